@@ -0,0 +1,179 @@
+#include "AssetLoader.h"
+#include "ImageArena.h"
+#include "stb_image.h"
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <iostream>
+
+int AssetLoader::request(const char* filepath)
+{
+    for (int i = 0; i < m_images.size(); i++) {
+        if (m_images[i].filepath == filepath) return i;
+    }
+
+    m_images.push_back(LoadedImage());
+    m_images.back().filepath = filepath;
+    return (int) (m_images.size() - 1);
+}
+
+int const LoadedImage::get_level_count() const
+{
+    if (cooked != NULL) return (int) cooked->level_count;
+    return 1 + (int) mip_chain.levels.size();
+}
+
+const unsigned char* LoadedImage::get_level(int level, int* level_width, int* level_height) const
+{
+    if (cooked != NULL) return get_cooked_level(cooked, level, level_width, level_height);
+
+    if (level == 0) {
+        *level_width  = width;
+        *level_height = height;
+        return pixels;
+    }
+
+    const MipLevel& mip = mip_chain.levels[level - 1];
+    *level_width  = mip.width;
+    *level_height = mip.height;
+    return mip_chain.get_level_pixels(level - 1);
+}
+
+bool AssetLoader::find_cooked(LoadedImage& image)
+{
+    size_t extension = image.filepath.rfind('.');
+    std::string cooked_path = image.filepath.substr(0, extension) + COOKED_TEXTURE_EXTENSION;
+
+    size_t cooked_size;
+    const unsigned char* cooked = m_pack != NULL ? m_pack->find(cooked_path.c_str(), &cooked_size) : NULL;
+    if (cooked == NULL && image.cooked_file.open(cooked_path.c_str())) {
+        cooked      = image.cooked_file.get_data();
+        cooked_size = image.cooked_file.get_size();
+    }
+    if (cooked == NULL) return false;
+
+    // a stale or differently cooked file falls back to the source image
+    const CookedTextureHeader* header = read_cooked_texture(cooked, cooked_size);
+    if (header == NULL || header->flags != m_cooked_flags) {
+        image.cooked_file.close();
+        return false;
+    }
+
+    // without its source there is nothing to compare against, so the cooked file is trusted
+    if (map_source(image) && !cooked_texture_matches(header, image.source, image.source_size)) {
+        std::cout << cooked_path << " was cooked from an older " << image.filepath << ", decoding the source instead" << std::endl;
+        image.cooked_file.close();
+        return false;
+    }
+    image.source = NULL;
+    image.source_file.close();
+
+    image.cooked = header;
+    image.width  = (int) header->width;
+    image.height = (int) header->height;
+    return true;
+}
+
+// the encoded bytes, in the pack or mapped from disk
+bool AssetLoader::map_source(LoadedImage& image)
+{
+    if (image.source != NULL) return true;
+
+    image.source = m_pack != NULL ? m_pack->find(image.filepath.c_str(), &image.source_size) : NULL;
+    if (image.source == NULL && image.source_file.open(image.filepath.c_str())) {
+        image.source      = image.source_file.get_data();
+        image.source_size = image.source_file.get_size();
+    }
+    return image.source != NULL;
+}
+
+// the encoded bytes and, from their header, the size of the decoded image
+bool AssetLoader::find_source(LoadedImage& image)
+{
+    // probing the formats allocates too
+    ImageArenaScope scratch;
+    int number_of_components;
+    if (!map_source(image) ||
+        !stbi_info_from_memory(image.source, (int) image.source_size, &image.width, &image.height, &number_of_components)) {
+        image.source = NULL;
+        image.source_file.close();
+        return false;
+    }
+    return true;
+}
+
+void AssetLoader::decode_image(LoadedImage& image, bool build_mips)
+{
+    // everything stb_image allocates is scratch, dropped when the scope ends
+    {
+        ImageArenaScope scratch;
+        int width, height, number_of_components;
+        size_t size = (size_t) image.width * image.height * 4;
+        if (!stbi_load_from_memory_into(image.source, (int) image.source_size, &width, &height, &number_of_components, STBI_rgb_alpha, image.pixels, size)) {
+            image.pixels = NULL;
+        }
+    }
+    if (image.pixels != NULL && build_mips) image.mip_chain.build(image.pixels, image.width, image.height);
+
+    image.source = NULL;
+    image.source_file.close();
+}
+
+bool AssetLoader::decode(unsigned int thread_count, bool build_mips)
+{
+    // sizes come from the headers up front, so the whole batch shares one pixel store
+    std::vector<int> pending;
+    std::vector<size_t> offsets;
+    size_t store_size = 0;
+    for (int i = 0; i < m_images.size(); i++) {
+        LoadedImage& image = m_images[i];
+        if (image.pixels != NULL || image.cooked != NULL || find_cooked(image) || !find_source(image)) continue;
+
+        // slices start on cache lines
+        pending.push_back(i);
+        offsets.push_back(store_size);
+        store_size += ((size_t) image.width * image.height * 4 + 63) & ~(size_t) 63;
+    }
+
+    unsigned char* store = pending.empty() ? NULL : (unsigned char*) malloc(store_size);
+    if (store != NULL) {
+        m_pixel_stores.push_back(store);
+        for (int i = 0; i < pending.size(); i++) m_images[pending[i]].pixels = store + offsets[i];
+    }
+    else pending.clear();
+
+    int count = (int) pending.size();
+    thread_count = std::max(1u, std::min(thread_count, (unsigned int) count));
+
+    // images differ wildly in size, so workers pull the next one instead of taking fixed shares
+    std::atomic<int> next(0);
+    auto work = [&]() {
+        for (int i = next++; i < count; i = next++) decode_image(m_images[pending[i]], build_mips);
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < thread_count; i++) workers.push_back(std::thread(work));
+    work();
+    for (int i = 0; i < workers.size(); i++) workers[i].join();
+
+    for (int i = 0; i < m_images.size(); i++) {
+        if (m_images[i].pixels == NULL && m_images[i].cooked == NULL) return false;
+    }
+    return true;
+}
+
+void AssetLoader::release()
+{
+    for (int i = 0; i < m_pixel_stores.size(); i++) free(m_pixel_stores[i]);
+    m_pixel_stores.clear();
+
+    for (int i = 0; i < m_images.size(); i++) {
+        m_images[i].pixels = NULL;
+        m_images[i].mip_chain = MipChain();
+        m_images[i].cooked = NULL;
+        m_images[i].cooked_file.close();
+        m_images[i].source = NULL;
+        m_images[i].source_file.close();
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "MipChain.h"
+#include "AssetPack.h"
+#include "MappedFile.h"
+#include "CookedTexture.h"
+
+// an RGBA8 image waiting to be uploaded: either decoded by stb_image into pixels and
+// mip_chain, or a cooked texture whose levels are read in place from the pack or a mapping
+struct LoadedImage
+{
+    std::string filepath;
+    unsigned char* pixels = NULL; // a slice of the loader's pixel store
+    int width  = 0;
+    int height = 0;
+    MipChain mip_chain;
+
+    // the encoded file while it waits to be decoded, in the pack or source_file
+    const unsigned char* source = NULL;
+    size_t source_size = 0;
+    MappedFile source_file;
+
+    const CookedTextureHeader* cooked = NULL;
+    MappedFile cooked_file;
+
+    // level 0 is the full image, whichever way it was loaded
+    int const get_level_count() const;
+    const unsigned char* get_level(int level, int* level_width, int* level_height) const;
+};
+
+// Collects the images a scene needs, then decodes them all at once across a pool of threads.
+// Decoding touches no GL, so uploading is left to the caller on the thread owning the context.
+// Images found in the asset pack are decoded straight from its mapping; others come from disk.
+// A cooked .tex next to an image (sprites/tile.png -> sprites/tile.tex) skips decoding entirely,
+// as long as it was cooked from the image as it is now.
+// Every image of a batch decodes into its slice of one pixel store, and stb_image's scratch
+// memory comes from a per-thread ImageArena, so a batch makes a handful of heap allocations.
+class AssetLoader
+{
+private:
+    std::vector<LoadedImage> m_images;
+    std::vector<unsigned char*> m_pixel_stores; // one per decode() that had images to decode
+    const AssetPack* m_pack = NULL;
+    uint32_t m_cooked_flags = 0;
+
+    bool map_source(LoadedImage& image);
+    bool find_cooked(LoadedImage& image);
+    bool find_source(LoadedImage& image);
+    void decode_image(LoadedImage& image, bool build_mips);
+
+public:
+    void set_pack(const AssetPack* pack) { m_pack = pack; };
+
+    // cooked textures are only used when cooked with exactly these CookedTextureFlags
+    void set_cooked_flags(uint32_t flags) { m_cooked_flags = flags; };
+
+    // returns a handle; asking for the same file twice returns the same handle
+    int request(const char* filepath);
+
+    // false if any image failed to decode; a thread_count of 1 decodes on the calling thread
+    bool decode(unsigned int thread_count, bool build_mips);
+
+    // frees every decoded image; handles stay valid for the next batch of requests
+    void release();
+
+    LoadedImage& get_image(int handle) { return m_images[handle]; };
+    int const get_image_count() const { return (int) m_images.size(); };
+};
@@ -0,0 +1,58 @@
+#include "AssetPack.h"
+#include <cstring>
+
+bool AssetPack::open(const char* filepath)
+{
+    close();
+
+    if (!m_file.open(filepath)) return false;
+    const unsigned char* data = m_file.get_data();
+    size_t size = m_file.get_size();
+
+    // validate everything up front, so find() can trust the index
+    const PackHeader* header = (const PackHeader*) data;
+    bool valid = size >= sizeof(PackHeader) && header->magic == PACK_MAGIC && header->version == PACK_VERSION &&
+                 header->entry_count <= (size - sizeof(PackHeader)) / sizeof(PackEntry);
+
+    if (valid) {
+        m_entries     = (const PackEntry*) (data + sizeof(PackHeader));
+        m_entry_count = header->entry_count;
+
+        for (uint32_t i = 0; i < m_entry_count && valid; i++) {
+            const PackEntry& entry = m_entries[i];
+            valid = entry.name[PACK_NAME_SIZE - 1] == '\0' && entry.offset <= size && entry.size <= size - entry.offset &&
+                    (i == 0 || strcmp(m_entries[i - 1].name, entry.name) < 0);
+        }
+    }
+
+    if (!valid) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void AssetPack::close()
+{
+    m_file.close();
+    m_entries     = NULL;
+    m_entry_count = 0;
+}
+
+const unsigned char* AssetPack::find(const char* name, size_t* size) const
+{
+    // the index is sorted by name
+    uint32_t low = 0, high = m_entry_count;
+    while (low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        int order = strcmp(m_entries[middle].name, name);
+
+        if (order == 0) {
+            *size = (size_t) m_entries[middle].size;
+            return m_file.get_data() + m_entries[middle].offset;
+        }
+        if (order < 0) low = middle + 1;
+        else high = middle;
+    }
+    return NULL;
+}
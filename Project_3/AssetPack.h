@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "MappedFile.h"
+
+// ————— FILE FORMAT ————— //
+// | PackHeader | PackEntry x entry_count, sorted by name | blobs, each starting on PACK_ALIGNMENT |
+// Written by tools/pack_assets.cpp; all integers little-endian.
+const uint32_t PACK_MAGIC     = 0x4b504c4c; // "LLPK"
+const uint32_t PACK_VERSION   = 1;
+const uint64_t PACK_ALIGNMENT = 64;
+const int      PACK_NAME_SIZE = 48;
+
+struct PackHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+};
+
+// name is the path the game asks for, e.g. "sprites/tile.png", NUL-padded
+struct PackEntry
+{
+    char     name[PACK_NAME_SIZE];
+    uint64_t offset;
+    uint64_t size;
+};
+
+// A read-only pack file mapped into memory. Lookups hand out pointers straight into the
+// mapping, so decoders read assets without another copy; they stay valid until close().
+class AssetPack
+{
+private:
+    MappedFile m_file;
+    const PackEntry* m_entries = NULL;
+    uint32_t m_entry_count = 0;
+
+public:
+    // false if the file is missing or is not a valid pack
+    bool open(const char* filepath);
+    void close();
+
+    // NULL if the pack has no such asset
+    const unsigned char* find(const char* name, size_t* size) const;
+
+    bool const is_open() const { return m_file.is_open(); };
+};
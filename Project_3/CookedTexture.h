@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ————— FILE FORMAT ————— //
+// | CookedTextureHeader | padding to COOKED_TEXTURE_DATA_OFFSET | level 0 | level 1 | ... |
+// Each level is tightly packed RGBA8, rows top to bottom unless COOKED_TEXTURE_FLIPPED,
+// and half the size of the one before (rounded down, never below 1), exactly as
+// glTexImage2D wants them. Written by tools/cook_textures.cpp; integers little-endian.
+// source_size and source_hash identify the encoded image it was cooked from, so a cooked
+// file left behind after its source is edited can be told apart from a current one.
+const uint32_t COOKED_TEXTURE_MAGIC       = 0x58544c4c; // "LLTX"
+const uint32_t COOKED_TEXTURE_VERSION     = 2;
+const size_t   COOKED_TEXTURE_DATA_OFFSET = 64;
+const char     COOKED_TEXTURE_EXTENSION[] = ".tex";
+
+enum CookedTextureFlags
+{
+    COOKED_TEXTURE_PREMULTIPLIED = 1 << 0,
+    COOKED_TEXTURE_FLIPPED       = 1 << 1,
+};
+
+struct CookedTextureHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t level_count;
+    uint32_t flags;
+    uint32_t source_size;
+    uint64_t source_hash;
+};
+
+// FNV-1a over the encoded source file
+inline uint64_t cooked_source_hash(const unsigned char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// whether header was cooked from exactly these bytes
+inline bool cooked_texture_matches(const CookedTextureHeader* header, const unsigned char* source, size_t source_size)
+{
+    return header->source_size == source_size && header->source_hash == cooked_source_hash(source, source_size);
+}
+
+inline size_t cooked_level_size(uint32_t width, uint32_t height, int level)
+{
+    size_t level_width  = width >> level  ? width >> level  : 1;
+    size_t level_height = height >> level ? height >> level : 1;
+    return level_width * level_height * 4;
+}
+
+// the header, or NULL if data is not a complete cooked texture
+inline const CookedTextureHeader* read_cooked_texture(const unsigned char* data, size_t size)
+{
+    if (size < COOKED_TEXTURE_DATA_OFFSET) return NULL;
+
+    const CookedTextureHeader* header = (const CookedTextureHeader*) data;
+    if (header->magic != COOKED_TEXTURE_MAGIC || header->version != COOKED_TEXTURE_VERSION) return NULL;
+    if (header->width == 0 || header->height == 0 || header->level_count == 0 || header->level_count > 32) return NULL;
+
+    size_t total = COOKED_TEXTURE_DATA_OFFSET;
+    for (uint32_t level = 0; level < header->level_count; level++) total += cooked_level_size(header->width, header->height, level);
+    return total <= size ? header : NULL;
+}
+
+// pixels of one level of a header returned by read_cooked_texture
+inline const unsigned char* get_cooked_level(const CookedTextureHeader* header, int level, int* width, int* height)
+{
+    const unsigned char* pixels = (const unsigned char*) header + COOKED_TEXTURE_DATA_OFFSET;
+    for (int i = 0; i < level; i++) pixels += cooked_level_size(header->width, header->height, i);
+
+    *width  = header->width >> level  ? (int) (header->width >> level)  : 1;
+    *height = header->height >> level ? (int) (header->height >> level) : 1;
+    return pixels;
+}
@@ -0,0 +1,60 @@
+#include "DynamicResolution.h"
+
+const float  SCALE_STEP           = 0.05f;
+const double AVERAGE_WEIGHT       = 0.1;   // per-frame weight of the moving average
+const double OVER_BUDGET          = 1.10;  // drop above this fraction of the budget
+const double UNDER_BUDGET         = 0.75;  // rise below it
+const int    COOLDOWN_FRAMES      = 15;    // let the average settle after a change
+const int    FIRST_PROBE_FRAMES   = 120;
+const int    MAX_PROBE_FRAMES     = 1920;
+
+void DynamicResolution::start(double budget_seconds, float min_scale, float max_scale)
+{
+    m_budget        = budget_seconds;
+    m_min_scale     = min_scale;
+    m_max_scale     = max_scale;
+    m_scale         = max_scale;
+    m_average       = budget_seconds;
+    m_cooldown      = COOLDOWN_FRAMES;
+    m_stable_frames = 0;
+    m_probe_frames  = FIRST_PROBE_FRAMES;
+    m_probing       = false;
+}
+
+void DynamicResolution::change_scale(float delta)
+{
+    float scale = m_scale + delta;
+    if (scale < m_min_scale) scale = m_min_scale;
+    if (scale > m_max_scale) scale = m_max_scale;
+    
+    m_scale         = scale;
+    m_average       = m_budget;
+    m_cooldown      = COOLDOWN_FRAMES;
+    m_stable_frames = 0;
+}
+
+void DynamicResolution::frame_finished(double frame_seconds)
+{
+    m_average += (frame_seconds - m_average) * AVERAGE_WEIGHT;
+    
+    if (m_cooldown > 0) { m_cooldown--; return; }
+    
+    if (m_average > m_budget * OVER_BUDGET) {
+        // a probe that failed right away: wait twice as long before the next one
+        if (m_probing && m_probe_frames < MAX_PROBE_FRAMES) m_probe_frames *= 2;
+        m_probing = false;
+        change_scale(-SCALE_STEP);
+    }
+    else if (m_average < m_budget * UNDER_BUDGET) {
+        m_probing = false;
+        change_scale(SCALE_STEP);
+    }
+    else if (++m_stable_frames >= m_probe_frames && m_scale < m_max_scale) {
+        m_probing = true;
+        change_scale(SCALE_STEP);
+    }
+    else if (m_stable_frames >= COOLDOWN_FRAMES) {
+        // the probe held
+        m_probing = false;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+// Picks the fraction of the window resolution the scene is rendered at, from measured frame times.
+// Drops a step as soon as frames run over budget. Under vsync a frame that fits always looks
+// like exactly one period, so headroom cannot be seen directly: after a stretch of frames on
+// budget it probes one step up, and backs off for longer every time a probe fails.
+class DynamicResolution
+{
+private:
+    float  m_scale       = 1.0f;
+    float  m_min_scale   = 0.5f;
+    float  m_max_scale   = 1.0f;
+    double m_budget      = 1.0 / 60.0;
+    double m_average     = 0.0;
+    int    m_cooldown    = 0;
+    int    m_stable_frames = 0;
+    int    m_probe_frames  = 0;
+    bool   m_probing       = false; // the last step up was a probe, not measured headroom
+    
+    void change_scale(float delta);
+    
+public:
+    void start(double budget_seconds, float min_scale, float max_scale);
+    
+    // frame_seconds: time spent producing the frame, including the swap
+    void frame_finished(double frame_seconds);
+    
+    float const get_scale() const { return m_scale; };
+};
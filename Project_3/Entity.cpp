@@ -11,6 +11,7 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "GLState.h"
 #include "Entity.h"
 
 Entity::Entity() {
@@ -54,21 +55,21 @@ void Entity::update(float delta_time, Entity* collidable_entities, int collidabl
 
 void Entity::render(ShaderProgram* program) {
     program->set_model_matrix(model_matrix);
+    GLState::use_program(program->get_program_id());
 
-    float vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
-    float tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
+    // static so the arrays outlive the call while the attributes stay enabled
+    static const float vertices[] = { -0.5, -0.5, 0.5, -0.5, 0.5, 0.5, -0.5, -0.5, 0.5, 0.5, -0.5, 0.5 };
+    static const float tex_coords[] = { 0.0,  1.0, 1.0,  1.0, 1.0, 0.0,  0.0,  1.0, 1.0, 0.0,  0.0, 0.0 };
 
-    glBindTexture(GL_TEXTURE_2D, texture_id);
+    GLState::bind_texture(texture_id);
+    GLState::bind_array_buffer(0);
 
     glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, vertices);
-    glEnableVertexAttribArray(program->get_position_attribute());
+    GLState::enable_attribute(program->get_position_attribute());
     glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, tex_coords);
-    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
+    GLState::enable_attribute(program->get_tex_coordinate_attribute());
 
     glDrawArrays(GL_TRIANGLES, 0, 6);
-
-    glDisableVertexAttribArray(program->get_position_attribute());
-    glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
 }
 
 void const Entity::check_collision_y(Entity* collidable_entities, int collidable_entity_count) {
@@ -131,3 +132,13 @@ bool const Entity::check_collision(Entity* other) const {
 
     return (x_distance < 0.0f && y_distance < 0.0f) ? true : false;
 }
+
+// view_bounds is (left, right, bottom, top) in world space
+bool const Entity::in_view(const glm::vec4& view_bounds) const {
+    
+    float half_width  = width / 2.0f;
+    float half_height = height / 2.0f;
+
+    return position.x + half_width  >= view_bounds.x && position.x - half_width  <= view_bounds.y &&
+           position.y + half_height >= view_bounds.z && position.y - half_height <= view_bounds.w;
+}
@@ -36,6 +36,7 @@ public:
     ~Entity();
     
     bool const check_collision(Entity* other) const;
+    bool const in_view(const glm::vec4& view_bounds) const;
     void const check_collision_y(Entity* collidable_entities, int collidable_entity_count);
     void const check_collision_x(Entity* collidable_entities, int collidable_entity_count);
 
@@ -50,6 +51,7 @@ public:
     glm::vec3 const get_velocity()     const { return velocity; };
     glm::vec3 const get_acceleration() const { return acceleration; };
     glm::vec3 const get_movement()     const { return movement; };
+    glm::mat4 const get_model_matrix() const { return model_matrix; };
     float     const get_speed()        const { return speed; };
     int       const get_width()        const { return width; };
     int       const get_height()       const { return height; };
@@ -0,0 +1,5 @@
+#pragma once
+
+// the font sheet is a FONTBANK_SIZE x FONTBANK_SIZE grid of glyphs, indexed by character code;
+// shared by the GL and software text paths
+const int FONTBANK_SIZE = 16;
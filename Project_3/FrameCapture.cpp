@@ -0,0 +1,137 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "FrameCapture.h"
+#include <cstdio>
+#include <cstring>
+
+const int CAPTURE_BYTES_PER_PIXEL = 4;
+const int TGA_HEADER_SIZE = 18;
+
+void FrameCapture::start(int width, int height, const std::string& prefix)
+{
+    m_width  = width;
+    m_height = height;
+    m_prefix = prefix;
+    m_frames_captured = 0;
+    m_stopping = false;
+    
+    glGenBuffers(2, m_pixel_buffers);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixel_buffers[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width * height * CAPTURE_BYTES_PER_PIXEL, NULL, GL_STREAM_READ);
+        m_in_flight[i] = false;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
+    m_writer = std::thread(&FrameCapture::writer_loop, this);
+}
+
+void FrameCapture::capture()
+{
+    int buffer = m_next_buffer;
+    
+    // BGRA is the layout TGA wants and the one most drivers read back without converting
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixel_buffers[buffer]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, m_width, m_height, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+    m_in_flight[buffer] = true;
+    m_frame_numbers[buffer] = m_frames_captured++;
+    
+    // the other buffer was queued a frame ago and should be ready by now
+    m_next_buffer = 1 - buffer;
+    if (m_in_flight[m_next_buffer]) collect(m_next_buffer);
+    
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void FrameCapture::collect(int buffer)
+{
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pixel_buffers[buffer]);
+    const unsigned char* mapped = (const unsigned char*) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    m_in_flight[buffer] = false;
+    if (mapped == NULL) return;
+    
+    CapturedFrame frame;
+    frame.number = m_frame_numbers[buffer];
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free_pixels.empty()) {
+            frame.pixels.swap(m_free_pixels.back());
+            m_free_pixels.pop_back();
+        }
+    }
+    frame.pixels.resize(m_width * m_height * CAPTURE_BYTES_PER_PIXEL);
+    memcpy(frame.pixels.data(), mapped, frame.pixels.size());
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(frame));
+    }
+    m_condition.notify_one();
+}
+
+void FrameCapture::stop()
+{
+    if (!m_writer.joinable()) return;
+    
+    for (int i = 0; i < 2; i++) {
+        int buffer = (m_next_buffer + i) % 2;
+        if (m_in_flight[buffer]) collect(buffer);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glDeleteBuffers(2, m_pixel_buffers);
+    
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_one();
+    m_writer.join();
+}
+
+void FrameCapture::writer_loop()
+{
+    while (true) {
+        CapturedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+            if (m_queue.empty()) return;
+            
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        
+        write_tga(frame);
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_free_pixels.push_back(std::move(frame.pixels));
+    }
+}
+
+void FrameCapture::write_tga(const CapturedFrame& frame)
+{
+    char filename[512];
+    snprintf(filename, sizeof(filename), "%s%05u.tga", m_prefix.c_str(), frame.number);
+    
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) {
+        printf("Error opening capture file %s!\n", filename);
+        return;
+    }
+    
+    // uncompressed true-colour, 32 bpp, 8 alpha bits, origin bottom-left like glReadPixels
+    unsigned char header[TGA_HEADER_SIZE] = {};
+    header[2]  = 2;
+    header[12] = m_width & 0xff;
+    header[13] = (m_width >> 8) & 0xff;
+    header[14] = m_height & 0xff;
+    header[15] = (m_height >> 8) & 0xff;
+    header[16] = 32;
+    header[17] = 8;
+    
+    fwrite(header, 1, TGA_HEADER_SIZE, file);
+    fwrite(frame.pixels.data(), 1, frame.pixels.size(), file);
+    fclose(file);
+}
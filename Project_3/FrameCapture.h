@@ -0,0 +1,60 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// one frame's pixels on their way to disk
+struct CapturedFrame
+{
+    unsigned int number;
+    std::vector<unsigned char> pixels;
+};
+
+// Reads back rendered frames without stalling the pipeline.
+// Each capture() queues an asynchronous glReadPixels into one of two pixel buffer objects
+// and maps the other one, which the GPU finished filling a frame ago. The copied pixels
+// go to a writer thread that saves them as <prefix>NNNNN.tga.
+class FrameCapture
+{
+private:
+    GLuint m_pixel_buffers[2] = { 0, 0 };
+    bool   m_in_flight[2]     = { false, false };
+    unsigned int m_frame_numbers[2] = { 0, 0 };
+    int    m_next_buffer      = 0;
+    int    m_width            = 0;
+    int    m_height           = 0;
+    unsigned int m_frames_captured = 0;
+    std::string m_prefix;
+    
+    // ————— WRITER THREAD ————— //
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::deque<CapturedFrame> m_queue;
+    std::vector<std::vector<unsigned char>> m_free_pixels; // recycled so steady-state capture does not allocate
+    bool m_stopping = false;
+    
+    void collect(int buffer);
+    void writer_loop();
+    void write_tga(const CapturedFrame& frame);
+    
+public:
+    void start(int width, int height, const std::string& prefix);
+    
+    // reads the currently bound read framebuffer
+    void capture();
+    
+    // drains the frame still in flight, then waits for the writer to finish
+    void stop();
+    
+    unsigned int const get_frames_captured() const { return m_frames_captured; };
+};
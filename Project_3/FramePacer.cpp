@@ -0,0 +1,57 @@
+#include "FramePacer.h"
+
+// never trust a sleep closer to the deadline than this
+const double MIN_SPIN_SECONDS = 0.0005;
+
+void FramePacer::start(double target_hz)
+{
+    m_frequency       = SDL_GetPerformanceFrequency();
+    m_sleep_overshoot = (Uint64) (m_frequency * 0.001);
+    set_target_rate(target_hz);
+    m_next_deadline   = SDL_GetPerformanceCounter() + m_period;
+}
+
+void FramePacer::set_target_rate(double target_hz)
+{
+    m_period = (Uint64) (m_frequency / target_hz);
+}
+
+void FramePacer::wait()
+{
+    if (m_vsync) return;
+    
+    Uint64 now = SDL_GetPerformanceCounter();
+    
+    // more than a whole frame late (breakpoint, window drag...): start over instead of racing to catch up
+    if (now > m_next_deadline + m_period) {
+        m_next_deadline = now + m_period;
+        return;
+    }
+    
+    Uint64 spin_margin = m_sleep_overshoot + (Uint64) (m_frequency * MIN_SPIN_SECONDS);
+    
+    // coarse part: sleep whole milliseconds while we are well clear of the deadline
+    while (now + spin_margin < m_next_deadline) {
+        Uint64 sleep_ticks = m_next_deadline - now - spin_margin;
+        Uint32 sleep_ms = (Uint32) (sleep_ticks * 1000 / m_frequency);
+        if (sleep_ms == 0) break;
+        
+        SDL_Delay(sleep_ms);
+        
+        Uint64 woke = SDL_GetPerformanceCounter();
+        Uint64 requested = (Uint64) sleep_ms * m_frequency / 1000;
+        Uint64 overshoot = woke - now > requested ? woke - now - requested : 0;
+        
+        // rise quickly on a late wake-up, decay slowly otherwise
+        if (overshoot > m_sleep_overshoot) m_sleep_overshoot = overshoot;
+        else m_sleep_overshoot -= (m_sleep_overshoot - overshoot) / 16;
+        
+        spin_margin = m_sleep_overshoot + (Uint64) (m_frequency * MIN_SPIN_SECONDS);
+        now = woke;
+    }
+    
+    // fine part
+    while (now < m_next_deadline) now = SDL_GetPerformanceCounter();
+    
+    m_next_deadline += m_period;
+}
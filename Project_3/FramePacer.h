@@ -0,0 +1,29 @@
+#pragma once
+
+#include <SDL.h>
+
+// Holds a loop to a target rate without burning a core.
+// wait() sleeps through most of the remaining frame with SDL_Delay, whose wake-up is only
+// good to a millisecond or two, and spins on the performance counter for the rest.
+// The spin margin tracks how late the OS has actually been waking us.
+class FramePacer
+{
+private:
+    Uint64 m_frequency      = 0;
+    Uint64 m_period         = 0; // in performance counter ticks
+    Uint64 m_next_deadline  = 0;
+    Uint64 m_sleep_overshoot = 0; // running estimate, in ticks
+    bool   m_vsync          = false;
+    
+public:
+    void start(double target_hz);
+    void set_target_rate(double target_hz);
+    
+    // when the swap already blocks on the display, wait() returns immediately
+    void set_vsync(bool vsync) { m_vsync = vsync; };
+    
+    void wait();
+    
+    double const get_target_seconds() const { return (double) m_period / m_frequency; };
+    bool   const get_vsync()          const { return m_vsync; };
+};
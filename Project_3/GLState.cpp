@@ -0,0 +1,101 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "GLState.h"
+
+GLuint GLState::m_program      = UNKNOWN_BINDING;
+GLuint GLState::m_texture      = UNKNOWN_BINDING;
+GLuint GLState::m_array_buffer = UNKNOWN_BINDING;
+int    GLState::m_attribute_enabled[MAX_TRACKED_ATTRIBUTES] = { UNKNOWN_TOGGLE, UNKNOWN_TOGGLE, UNKNOWN_TOGGLE, UNKNOWN_TOGGLE,
+                                                                UNKNOWN_TOGGLE, UNKNOWN_TOGGLE, UNKNOWN_TOGGLE, UNKNOWN_TOGGLE,
+                                                                UNKNOWN_TOGGLE, UNKNOWN_TOGGLE, UNKNOWN_TOGGLE, UNKNOWN_TOGGLE,
+                                                                UNKNOWN_TOGGLE, UNKNOWN_TOGGLE, UNKNOWN_TOGGLE, UNKNOWN_TOGGLE };
+int    GLState::m_blend_enabled = UNKNOWN_TOGGLE;
+GLenum GLState::m_blend_src_rgb   = UNKNOWN_BINDING;
+GLenum GLState::m_blend_dst_rgb   = UNKNOWN_BINDING;
+GLenum GLState::m_blend_src_alpha = UNKNOWN_BINDING;
+GLenum GLState::m_blend_dst_alpha = UNKNOWN_BINDING;
+
+unsigned long GLState::m_calls_issued  = 0;
+unsigned long GLState::m_calls_skipped = 0;
+
+void GLState::invalidate()
+{
+    m_program = m_texture = m_array_buffer = UNKNOWN_BINDING;
+    for (int i = 0; i < MAX_TRACKED_ATTRIBUTES; i++) m_attribute_enabled[i] = UNKNOWN_TOGGLE;
+    m_blend_enabled = UNKNOWN_TOGGLE;
+    m_blend_src_rgb = m_blend_dst_rgb = m_blend_src_alpha = m_blend_dst_alpha = UNKNOWN_BINDING;
+}
+
+void GLState::use_program(GLuint program)
+{
+    if (m_program == program) { m_calls_skipped++; return; }
+    
+    glUseProgram(program);
+    m_program = program;
+    m_calls_issued++;
+}
+
+void GLState::bind_texture(GLuint texture)
+{
+    if (m_texture == texture) { m_calls_skipped++; return; }
+    
+    glBindTexture(GL_TEXTURE_2D, texture);
+    m_texture = texture;
+    m_calls_issued++;
+}
+
+void GLState::bind_array_buffer(GLuint buffer)
+{
+    if (m_array_buffer == buffer) { m_calls_skipped++; return; }
+    
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    m_array_buffer = buffer;
+    m_calls_issued++;
+}
+
+void GLState::enable_attribute(GLuint index)
+{
+    if (index < MAX_TRACKED_ATTRIBUTES && m_attribute_enabled[index] == 1) { m_calls_skipped++; return; }
+    
+    glEnableVertexAttribArray(index);
+    if (index < MAX_TRACKED_ATTRIBUTES) m_attribute_enabled[index] = 1;
+    m_calls_issued++;
+}
+
+void GLState::disable_attribute(GLuint index)
+{
+    if (index < MAX_TRACKED_ATTRIBUTES && m_attribute_enabled[index] == 0) { m_calls_skipped++; return; }
+    
+    glDisableVertexAttribArray(index);
+    if (index < MAX_TRACKED_ATTRIBUTES) m_attribute_enabled[index] = 0;
+    m_calls_issued++;
+}
+
+void GLState::set_blend(bool enabled)
+{
+    if (m_blend_enabled == (int) enabled) { m_calls_skipped++; return; }
+    
+    if (enabled) glEnable(GL_BLEND);
+    else         glDisable(GL_BLEND);
+    m_blend_enabled = (int) enabled;
+    m_calls_issued++;
+}
+
+void GLState::set_blend_func(GLenum src, GLenum dst)
+{
+    set_blend_func(src, dst, src, dst);
+}
+
+void GLState::set_blend_func(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha)
+{
+    if (m_blend_src_rgb == src_rgb && m_blend_dst_rgb == dst_rgb &&
+        m_blend_src_alpha == src_alpha && m_blend_dst_alpha == dst_alpha) { m_calls_skipped++; return; }
+    
+    if (src_rgb == src_alpha && dst_rgb == dst_alpha) glBlendFunc(src_rgb, dst_rgb);
+    else glBlendFuncSeparate(src_rgb, dst_rgb, src_alpha, dst_alpha);
+    m_blend_src_rgb   = src_rgb;
+    m_blend_dst_rgb   = dst_rgb;
+    m_blend_src_alpha = src_alpha;
+    m_blend_dst_alpha = dst_alpha;
+    m_calls_issued++;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+
+const int MAX_TRACKED_ATTRIBUTES = 16;
+const GLuint UNKNOWN_BINDING = (GLuint) -1;
+const int    UNKNOWN_TOGGLE  = -1;
+
+// Shadows the bits of GL state we touch every frame and drops calls that would not change it.
+// All GL work goes through a single context on a single thread, so plain statics are enough.
+class GLState
+{
+private:
+    static GLuint m_program;
+    static GLuint m_texture;
+    static GLuint m_array_buffer;
+    static int    m_attribute_enabled[MAX_TRACKED_ATTRIBUTES];
+    static int    m_blend_enabled;
+    static GLenum m_blend_src_rgb;
+    static GLenum m_blend_dst_rgb;
+    static GLenum m_blend_src_alpha;
+    static GLenum m_blend_dst_alpha;
+
+    static unsigned long m_calls_issued;
+    static unsigned long m_calls_skipped;
+
+public:
+    static void use_program(GLuint program);
+    static void bind_texture(GLuint texture);
+    static void bind_array_buffer(GLuint buffer);
+    static void enable_attribute(GLuint index);
+    static void disable_attribute(GLuint index);
+    static void set_blend(bool enabled);
+    static void set_blend_func(GLenum src, GLenum dst);
+    static void set_blend_func(GLenum src_rgb, GLenum dst_rgb, GLenum src_alpha, GLenum dst_alpha);
+
+    // forget everything we know, e.g. after something outside GLState has touched the context
+    static void invalidate();
+
+    // for state tracked elsewhere (uniform values live on each ShaderProgram)
+    static void count_issued()  { m_calls_issued++;  };
+    static void count_skipped() { m_calls_skipped++; };
+
+    static unsigned long const get_calls_issued()  { return m_calls_issued;  };
+    static unsigned long const get_calls_skipped() { return m_calls_skipped; };
+    static void reset_counters() { m_calls_issued = 0; m_calls_skipped = 0; };
+};
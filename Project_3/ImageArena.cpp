@@ -0,0 +1,125 @@
+#include "ImageArena.h"
+#include <cstdlib>
+#include <cstring>
+
+static const size_t ARENA_ALIGNMENT = 16;
+
+struct ImageArena
+{
+    unsigned char* block = NULL;
+    size_t capacity = 0;
+    size_t used     = 0;
+    int depth       = 0; // nested scopes
+
+    // the most recent allocation is the only one that can grow or be given back in place
+    unsigned char* last = NULL;
+
+    // what the scope would have needed to fit entirely in the block; heap fallbacks are
+    // counted until the scope ends, as their sizes are not known when they are freed
+    size_t overflow = 0;
+    size_t needed   = 0;
+
+    ~ImageArena() { free(block); };
+};
+
+static thread_local ImageArena t_arena;
+
+static size_t align_size(size_t size)
+{
+    return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+static bool owns(const ImageArena& arena, const void* pointer)
+{
+    return pointer >= arena.block && pointer < arena.block + arena.capacity;
+}
+
+static void note_needed(ImageArena& arena)
+{
+    if (arena.used + arena.overflow > arena.needed) arena.needed = arena.used + arena.overflow;
+}
+
+// ————— ALLOCATION ————— //
+void* image_arena_malloc(size_t size)
+{
+    ImageArena& arena = t_arena;
+    if (arena.depth == 0) return malloc(size);
+
+    size = align_size(size > 0 ? size : 1);
+    if (size > arena.capacity - arena.used) {
+        arena.overflow += size;
+        note_needed(arena);
+        return malloc(size);
+    }
+
+    arena.last  = arena.block + arena.used;
+    arena.used += size;
+    note_needed(arena);
+    return arena.last;
+}
+
+void* image_arena_realloc(void* pointer, size_t old_size, size_t size)
+{
+    ImageArena& arena = t_arena;
+    if (pointer == NULL) return image_arena_malloc(size);
+    if (!owns(arena, pointer)) {
+        if (arena.depth > 0 && size > old_size) {
+            arena.overflow += size - old_size;
+            note_needed(arena);
+        }
+        return realloc(pointer, size);
+    }
+
+    // the last allocation grows or shrinks where it is while the block has room
+    size_t offset = (unsigned char*) pointer - arena.block;
+    if (pointer == arena.last && align_size(size) <= arena.capacity - offset) {
+        arena.used = offset + align_size(size);
+        note_needed(arena);
+        return pointer;
+    }
+    if (size <= old_size) return pointer;
+
+    void* moved = image_arena_malloc(size);
+    if (moved == NULL) return NULL;
+    memcpy(moved, pointer, old_size);
+    image_arena_free(pointer);
+    return moved;
+}
+
+void image_arena_free(void* pointer)
+{
+    ImageArena& arena = t_arena;
+    if (!owns(arena, pointer)) {
+        free(pointer);
+        return;
+    }
+
+    // everything else is reclaimed when the scope ends
+    if (pointer == arena.last) {
+        arena.used = (unsigned char*) pointer - arena.block;
+        arena.last = NULL;
+    }
+}
+
+// ————— SCOPES ————— //
+ImageArenaScope::ImageArenaScope()
+{
+    t_arena.depth++;
+}
+
+ImageArenaScope::~ImageArenaScope()
+{
+    ImageArena& arena = t_arena;
+    if (--arena.depth > 0) return;
+
+    // nothing in the block is live any more, so a larger one need not copy it
+    if (arena.needed > arena.capacity) {
+        free(arena.block);
+        arena.block    = (unsigned char*) malloc(arena.needed);
+        arena.capacity = arena.block != NULL ? arena.needed : 0;
+    }
+    arena.used     = 0;
+    arena.last     = NULL;
+    arena.overflow = 0;
+    arena.needed   = 0;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+// Scratch memory for stb_image, whose STBI_MALLOC/STBI_REALLOC_SIZED/STBI_FREE main.cpp points here.
+// While an ImageArenaScope is alive, the calling thread's allocations are bumped out of one block
+// that thread keeps from decode to decode; when the outermost scope ends everything in it is
+// dropped at once. Requests that do not fit go to the heap, and the block grows to what the
+// scope needed, so after the first few images a thread decodes without touching the heap.
+// Outside a scope these are plain malloc/realloc/free.
+void* image_arena_malloc(size_t size);
+void* image_arena_realloc(void* pointer, size_t old_size, size_t size);
+void  image_arena_free(void* pointer);
+
+// nothing allocated while a scope is alive may be used after it ends
+class ImageArenaScope
+{
+public:
+    ImageArenaScope();
+    ~ImageArenaScope();
+    ImageArenaScope(const ImageArenaScope&) = delete;
+    ImageArenaScope& operator=(const ImageArenaScope&) = delete;
+};
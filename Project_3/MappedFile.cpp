@@ -0,0 +1,90 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WINDOWS
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other)
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+    if (this == &other) return *this;
+    close();
+
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+#ifdef _WINDOWS
+    std::swap(m_file, other.m_file);
+    std::swap(m_mapping, other.m_mapping);
+#endif
+    return *this;
+}
+
+bool MappedFile::open(const char* filepath)
+{
+    close();
+
+#ifdef _WINDOWS
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER file_size;
+    HANDLE mapping = NULL;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file    = file;
+    m_mapping = mapping;
+    m_data    = (const unsigned char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    m_size    = (size_t) file_size.QuadPart;
+    if (m_data == NULL) {
+        close();
+        return false;
+    }
+#else
+    int file = ::open(filepath, O_RDONLY);
+    if (file < 0) return false;
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size <= 0) {
+        ::close(file);
+        return false;
+    }
+
+    // the mapping outlives the descriptor
+    void* data = mmap(NULL, (size_t) file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED) return false;
+
+    m_data = (const unsigned char*) data;
+    m_size = (size_t) file_stat.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WINDOWS
+    if (m_data != NULL) UnmapViewOfFile(m_data);
+    if (m_mapping != NULL) CloseHandle((HANDLE) m_mapping);
+    if (m_file != NULL) CloseHandle((HANDLE) m_file);
+    m_file = m_mapping = NULL;
+#else
+    if (m_data != NULL) munmap((void*) m_data, m_size);
+#endif
+
+    m_data = NULL;
+    m_size = 0;
+}
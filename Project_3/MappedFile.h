@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+// A whole file mapped read-only into memory; the bytes stay valid until close().
+class MappedFile
+{
+private:
+    const unsigned char* m_data = NULL;
+    size_t m_size = 0;
+
+#ifdef _WINDOWS
+    void* m_file    = NULL;
+    void* m_mapping = NULL;
+#endif
+
+public:
+    MappedFile() {};
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(MappedFile&& other);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); };
+
+    // false if the file is missing or empty
+    bool open(const char* filepath);
+    void close();
+
+    const unsigned char* const get_data() const { return m_data;         };
+    size_t               const get_size() const { return m_size;         };
+    bool                 const is_open()  const { return m_data != NULL; };
+};
@@ -0,0 +1,163 @@
+#include "MipChain.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define MIP_CHAIN_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define MIP_CHAIN_NEON
+#endif
+
+// ————— ROWS ————— //
+// destination pixel x from source pixels x0 and x1 of both rows. Straight alpha colour is
+// weighted by alpha, so transparent texels, whatever RGB they hold, do not bleed into the
+// edges of the smaller levels; premultiplied colour is already weighted and just averaged.
+static void downsample_pixel(const unsigned char* row0, const unsigned char* row1, int x0, int x1, unsigned char* destination, bool premultiplied)
+{
+    const unsigned char* block[4] = { row0 + x0 * 4, row0 + x1 * 4, row1 + x0 * 4, row1 + x1 * 4 };
+    int alpha_sum = block[0][3] + block[1][3] + block[2][3] + block[3][3];
+    destination[3] = (unsigned char) ((alpha_sum + 2) >> 2);
+
+    for (int channel = 0; channel < 3; channel++) {
+        int sum = block[0][channel] + block[1][channel] + block[2][channel] + block[3][channel];
+        if (premultiplied || alpha_sum == 0) {
+            destination[channel] = (unsigned char) ((sum + 2) >> 2);
+            continue;
+        }
+
+        int weighted = 0;
+        for (int i = 0; i < 4; i++) weighted += block[i][channel] * block[i][3];
+        destination[channel] = (unsigned char) ((weighted + alpha_sum / 2) / alpha_sum);
+    }
+}
+
+// destination pixel x averages source pixels 2x and 2x + 1 of both rows
+static void downsample_row(const unsigned char* row0, const unsigned char* row1, int source_width, unsigned char* destination, int width, bool premultiplied)
+{
+    int x = 0;
+
+    // The vector paths read 2x + 1, which only exists when the source is at least two wide.
+    // They take a plain average, which is only right for straight alpha where every texel
+    // read is opaque or every one is transparent; other steps go through downsample_pixel.
+    if (source_width >= 2) {
+#if defined(MIP_CHAIN_SSE2)
+        // four destination pixels per step: 32 source bytes from each row, summed in 16-bit lanes
+        const __m128i zero    = _mm_setzero_si128();
+        const __m128i ones    = _mm_set1_epi8(-1);
+        const __m128i rounder = _mm_set1_epi16(2);
+        const int     alphas  = 0x8888; // movemask bits of the alpha bytes
+
+        for (; x + 4 <= width; x += 4) {
+            const unsigned char* a = row0 + x * 8;
+            const unsigned char* b = row1 + x * 8;
+            __m128i a0 = _mm_loadu_si128((const __m128i*) a), a1 = _mm_loadu_si128((const __m128i*) (a + 16));
+            __m128i b0 = _mm_loadu_si128((const __m128i*) b), b1 = _mm_loadu_si128((const __m128i*) (b + 16));
+
+            if (!premultiplied) {
+                __m128i all = _mm_and_si128(_mm_and_si128(a0, a1), _mm_and_si128(b0, b1));
+                __m128i any = _mm_or_si128(_mm_or_si128(a0, a1), _mm_or_si128(b0, b1));
+                bool opaque      = (_mm_movemask_epi8(_mm_cmpeq_epi8(all, ones)) & alphas) == alphas;
+                bool transparent = (_mm_movemask_epi8(_mm_cmpeq_epi8(any, zero)) & alphas) == alphas;
+                if (!opaque && !transparent) {
+                    for (int i = x; i < x + 4; i++) downsample_pixel(row0, row1, 2 * i, 2 * i + 1, destination + i * 4, false);
+                    continue;
+                }
+            }
+
+            // vertical sums, two source pixels per register
+            __m128i s01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+            __m128i s23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+            __m128i s45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+            __m128i s67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+            // horizontal sums: even source pixels plus odd ones
+            __m128i p01 = _mm_add_epi16(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+            __m128i p23 = _mm_add_epi16(_mm_unpacklo_epi64(s45, s67), _mm_unpackhi_epi64(s45, s67));
+
+            p01 = _mm_srli_epi16(_mm_add_epi16(p01, rounder), 2);
+            p23 = _mm_srli_epi16(_mm_add_epi16(p23, rounder), 2);
+            _mm_storeu_si128((__m128i*) (destination + x * 4), _mm_packus_epi16(p01, p23));
+        }
+#elif defined(MIP_CHAIN_NEON)
+        const uint32x4_t alpha_mask = vdupq_n_u32(0xff000000);
+
+        for (; x + 4 <= width; x += 4) {
+            const unsigned char* a = row0 + x * 8;
+            const unsigned char* b = row1 + x * 8;
+            uint8x16_t a0 = vld1q_u8(a), a1 = vld1q_u8(a + 16);
+            uint8x16_t b0 = vld1q_u8(b), b1 = vld1q_u8(b + 16);
+
+            if (!premultiplied) {
+                // alpha bytes only: all set when every texel is opaque, all clear when none is visible
+                uint32x4_t all = vandq_u32(vreinterpretq_u32_u8(vandq_u8(vandq_u8(a0, a1), vandq_u8(b0, b1))), alpha_mask);
+                uint32x4_t any = vandq_u32(vreinterpretq_u32_u8(vorrq_u8(vorrq_u8(a0, a1), vorrq_u8(b0, b1))), alpha_mask);
+                uint64x2_t missing = vreinterpretq_u64_u32(veorq_u32(all, alpha_mask));
+                uint64x2_t present = vreinterpretq_u64_u32(any);
+                bool opaque      = (vgetq_lane_u64(missing, 0) | vgetq_lane_u64(missing, 1)) == 0;
+                bool transparent = (vgetq_lane_u64(present, 0) | vgetq_lane_u64(present, 1)) == 0;
+                if (!opaque && !transparent) {
+                    for (int i = x; i < x + 4; i++) downsample_pixel(row0, row1, 2 * i, 2 * i + 1, destination + i * 4, false);
+                    continue;
+                }
+            }
+
+            uint16x8_t s01 = vaddl_u8(vget_low_u8(a0),  vget_low_u8(b0));
+            uint16x8_t s23 = vaddl_u8(vget_high_u8(a0), vget_high_u8(b0));
+            uint16x8_t s45 = vaddl_u8(vget_low_u8(a1),  vget_low_u8(b1));
+            uint16x8_t s67 = vaddl_u8(vget_high_u8(a1), vget_high_u8(b1));
+
+            uint16x8_t p01 = vcombine_u16(vadd_u16(vget_low_u16(s01), vget_high_u16(s01)), vadd_u16(vget_low_u16(s23), vget_high_u16(s23)));
+            uint16x8_t p23 = vcombine_u16(vadd_u16(vget_low_u16(s45), vget_high_u16(s45)), vadd_u16(vget_low_u16(s67), vget_high_u16(s67)));
+
+            // rounding shift does the + 2 for us
+            vst1q_u8(destination + x * 4, vcombine_u8(vrshrn_n_u16(p01, 2), vrshrn_n_u16(p23, 2)));
+        }
+#endif
+    }
+
+    for (; x < width; x++) {
+        int x0 = 2 * x;
+        int x1 = std::min(x0 + 1, source_width - 1);
+        downsample_pixel(row0, row1, x0, x1, destination + x * 4, premultiplied);
+    }
+}
+
+void downsample_box(const unsigned char* source, int width, int height, unsigned char* destination, bool premultiplied)
+{
+    int half_width  = std::max(1, width / 2);
+    int half_height = std::max(1, height / 2);
+
+    for (int y = 0; y < half_height; y++) {
+        const unsigned char* row0 = source + (size_t) (2 * y) * width * 4;
+        const unsigned char* row1 = source + (size_t) std::min(2 * y + 1, height - 1) * width * 4;
+        downsample_row(row0, row1, width, destination + (size_t) y * half_width * 4, half_width, premultiplied);
+    }
+}
+
+// ————— CHAIN ————— //
+void MipChain::build(const unsigned char* image, int width, int height, bool premultiplied)
+{
+    levels.clear();
+
+    // lay out every level first, so the pixels are allocated once
+    size_t total = 0;
+    for (int w = width, h = height; w > 1 || h > 1;) {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+        levels.push_back({ w, h, total });
+        total += (size_t) w * h * 4;
+    }
+    pixels.resize(total);
+
+    const unsigned char* source = image;
+    int source_width = width, source_height = height;
+    for (size_t i = 0; i < levels.size(); i++) {
+        unsigned char* destination = pixels.data() + levels[i].offset;
+        downsample_box(source, source_width, source_height, destination, premultiplied);
+
+        source = destination;
+        source_width  = levels[i].width;
+        source_height = levels[i].height;
+    }
+}
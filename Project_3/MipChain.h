@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// one level below the base image; offset indexes MipChain::pixels
+struct MipLevel
+{
+    int width;
+    int height;
+    size_t offset;
+};
+
+// Levels 1..n of an RGBA8 image, each a 2x2 box filter of the one above, down to 1x1.
+// Level 0 stays with whoever decoded it; all other levels share one allocation.
+// Straight alpha colour is averaged weighted by alpha; pass premultiplied for images whose
+// colour already is.
+struct MipChain
+{
+    std::vector<unsigned char> pixels;
+    std::vector<MipLevel> levels;
+
+    void build(const unsigned char* image, int width, int height, bool premultiplied = false);
+    const unsigned char* get_level_pixels(int level) const { return pixels.data() + levels[level].offset; };
+};
+
+// halves an RGBA8 image (rounding sizes down, never below 1) by averaging 2x2 blocks
+void downsample_box(const unsigned char* source, int width, int height, unsigned char* destination, bool premultiplied = false);
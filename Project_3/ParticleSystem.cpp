@@ -0,0 +1,152 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "ParticleSystem.h"
+#include "GLState.h"
+#include "TransformFeedback.h"
+#include <vector>
+#include <cstdlib>
+
+const char PARTICLE_UPDATE_V_SHADER_PATH[] = "shaders/vertex_particle_update.glsl",
+           PARTICLE_UPDATE_F_SHADER_PATH[] = "shaders/fragment_particle_update.glsl",
+           PARTICLE_V_SHADER_PATH[]        = "shaders/vertex_particle.glsl",
+           PARTICLE_F_SHADER_PATH[]        = "shaders/fragment_particle.glsl";
+
+const char *const PARTICLE_FEEDBACK_VARYINGS[] = { "outPosition", "outVelocity", "outLife", "outSeed" };
+const int PARTICLE_FEEDBACK_VARYING_COUNT = 4;
+
+const GLsizei PARTICLE_STRIDE = PARTICLE_FLOATS * sizeof(float);
+const float PARTICLE_POINT_SIZE = 3.0f;
+const float PARTICLE_GRAVITY = -0.5f;
+const float PARTICLE_RED   = 1.0f,
+            PARTICLE_GREEN = 0.6f,
+            PARTICLE_BLUE  = 0.2f;
+
+// a driver can offer transform feedback and still reject our shaders
+static bool program_linked(const ShaderProgram& program)
+{
+    GLuint program_id = program.get_program_id();
+    if (program_id == 0) return false;
+    
+    GLint link_success = GL_FALSE;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &link_success);
+    return link_success == GL_TRUE;
+}
+
+bool ParticleSystem::create(int count)
+{
+    m_supported = false;
+    if (TransformFeedback::detect() == TRANSFORM_FEEDBACK_NONE) return false;
+    
+    m_update_program.load(PARTICLE_UPDATE_V_SHADER_PATH, PARTICLE_UPDATE_F_SHADER_PATH,
+                          PARTICLE_FEEDBACK_VARYINGS, PARTICLE_FEEDBACK_VARYING_COUNT);
+    m_draw_program.load(PARTICLE_V_SHADER_PATH, PARTICLE_F_SHADER_PATH);
+    if (!program_linked(m_update_program) || !program_linked(m_draw_program)) return false;
+    m_draw_program.set_colour(PARTICLE_RED, PARTICLE_GREEN, PARTICLE_BLUE, 1.0f);
+    
+    GLuint update_id = m_update_program.get_program_id();
+    m_delta_time_uniform        = glGetUniformLocation(update_id, "deltaTime");
+    m_time_uniform              = glGetUniformLocation(update_id, "time");
+    m_gravity_uniform           = glGetUniformLocation(update_id, "gravity");
+    m_emitter_position_uniform  = glGetUniformLocation(update_id, "emitterPosition");
+    m_emitter_direction_uniform = glGetUniformLocation(update_id, "emitterDirection");
+    m_emit_chance_uniform       = glGetUniformLocation(update_id, "emitChance");
+    m_burst_uniform             = glGetUniformLocation(update_id, "burst");
+    m_velocity_attribute        = glGetAttribLocation(update_id, "velocity");
+    m_life_attribute            = glGetAttribLocation(update_id, "life");
+    m_seed_attribute            = glGetAttribLocation(update_id, "seed");
+    m_draw_life_attribute       = glGetAttribLocation(m_draw_program.get_program_id(), "life");
+    
+    // every particle starts dead (age past its lifetime) with its own random seed
+    std::vector<float> initial(count * PARTICLE_FLOATS, 0.0f);
+    for (int i = 0; i < count; i++) {
+        float* particle = &initial[i * PARTICLE_FLOATS];
+        particle[4] = 1.0f;
+        particle[5] = 0.0f;
+        particle[6] = (float) rand() / RAND_MAX * 1000.0f;
+    }
+    
+    glGenBuffers(2, m_buffers);
+    for (int i = 0; i < 2; i++) {
+        GLState::bind_array_buffer(m_buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, initial.size() * sizeof(float), initial.data(), GL_STREAM_COPY);
+    }
+    GLState::bind_array_buffer(0);
+    
+    m_count     = count;
+    m_source    = 0;
+    m_time      = 0.0f;
+    m_supported = true;
+    
+    return m_supported;
+}
+
+void ParticleSystem::destroy()
+{
+    if (!m_supported) return;
+    
+    glDeleteBuffers(2, m_buffers);
+    m_buffers[0] = m_buffers[1] = 0;
+    GLState::invalidate();
+    m_supported = false;
+}
+
+void ParticleSystem::update(float delta_time, glm::vec2 emitter_position, glm::vec2 emit_direction, float emit_rate, bool burst)
+{
+    if (!m_supported) return;
+    
+    m_time += delta_time;
+    
+    // chance that a dead particle respawns this step; close enough while most of the pool is dead
+    float emit_chance = emit_rate * delta_time / m_count;
+    
+    GLState::use_program(m_update_program.get_program_id());
+    glUniform1f(m_delta_time_uniform, delta_time);
+    glUniform1f(m_time_uniform, m_time);
+    glUniform2f(m_gravity_uniform, 0.0f, PARTICLE_GRAVITY);
+    glUniform2f(m_emitter_position_uniform, emitter_position.x, emitter_position.y);
+    glUniform2f(m_emitter_direction_uniform, emit_direction.x, emit_direction.y);
+    glUniform1f(m_emit_chance_uniform, emit_chance);
+    glUniform1f(m_burst_uniform, burst ? 1.0f : 0.0f);
+    
+    GLState::bind_array_buffer(m_buffers[m_source]);
+    glVertexAttribPointer(m_update_program.get_position_attribute(), 2, GL_FLOAT, false, PARTICLE_STRIDE, (void*) 0);
+    GLState::enable_attribute(m_update_program.get_position_attribute());
+    glVertexAttribPointer(m_velocity_attribute, 2, GL_FLOAT, false, PARTICLE_STRIDE, (void*) (2 * sizeof(float)));
+    GLState::enable_attribute(m_velocity_attribute);
+    glVertexAttribPointer(m_life_attribute, 2, GL_FLOAT, false, PARTICLE_STRIDE, (void*) (4 * sizeof(float)));
+    GLState::enable_attribute(m_life_attribute);
+    glVertexAttribPointer(m_seed_attribute, 1, GL_FLOAT, false, PARTICLE_STRIDE, (void*) (6 * sizeof(float)));
+    GLState::enable_attribute(m_seed_attribute);
+    
+    TransformFeedback::bind_buffer(m_buffers[1 - m_source]);
+    TransformFeedback::begin_points();
+    glDrawArrays(GL_POINTS, 0, m_count);
+    TransformFeedback::end();
+    TransformFeedback::bind_buffer(0);
+    
+    // the sprite programs never read these; do not leave them pointing into our buffers
+    GLState::disable_attribute(m_velocity_attribute);
+    GLState::disable_attribute(m_life_attribute);
+    GLState::disable_attribute(m_seed_attribute);
+    
+    m_source = 1 - m_source;
+}
+
+void ParticleSystem::render()
+{
+    if (!m_supported) return;
+    
+    m_draw_program.set_model_matrix(glm::mat4(1.0f));
+    GLState::use_program(m_draw_program.get_program_id());
+    
+    GLState::bind_array_buffer(m_buffers[m_source]);
+    glVertexAttribPointer(m_draw_program.get_position_attribute(), 2, GL_FLOAT, false, PARTICLE_STRIDE, (void*) 0);
+    GLState::enable_attribute(m_draw_program.get_position_attribute());
+    glVertexAttribPointer(m_draw_life_attribute, 2, GL_FLOAT, false, PARTICLE_STRIDE, (void*) (4 * sizeof(float)));
+    GLState::enable_attribute(m_draw_life_attribute);
+    
+    glPointSize(PARTICLE_POINT_SIZE);
+    glDrawArrays(GL_POINTS, 0, m_count);
+    
+    GLState::disable_attribute(m_draw_life_attribute);
+}
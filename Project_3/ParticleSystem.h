@@ -0,0 +1,54 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+
+// position (2), velocity (2), life: age and lifetime (2), seed (1)
+const int PARTICLE_FLOATS = 7;
+
+// Particles that live entirely on the GPU. Each step a vertex shader reads every particle
+// from one buffer and transform feedback writes the advanced state into the other; the two
+// buffers then swap. The CPU only sets a handful of uniforms per step.
+class ParticleSystem
+{
+private:
+    ShaderProgram m_update_program;
+    ShaderProgram m_draw_program;
+    
+    GLuint m_buffers[2] = { 0, 0 };
+    int    m_source     = 0;
+    int    m_count      = 0;
+    float  m_time       = 0.0f;
+    bool   m_supported  = false;
+    
+    // ————— UPDATE UNIFORMS / ATTRIBUTES ————— //
+    GLint m_delta_time_uniform;
+    GLint m_time_uniform;
+    GLint m_gravity_uniform;
+    GLint m_emitter_position_uniform;
+    GLint m_emitter_direction_uniform;
+    GLint m_emit_chance_uniform;
+    GLint m_burst_uniform;
+    GLint m_velocity_attribute;
+    GLint m_life_attribute;
+    GLint m_seed_attribute;
+    GLint m_draw_life_attribute;
+    
+public:
+    // false when the context has neither GL 3.0 nor GL_EXT_transform_feedback, or the particle
+    // programs do not link; the system then does nothing
+    bool create(int count);
+    void destroy();
+    
+    // emit_rate is particles per second along emit_direction; burst respawns every particle at once
+    void update(float delta_time, glm::vec2 emitter_position, glm::vec2 emit_direction, float emit_rate, bool burst);
+    void render();
+    
+    ShaderProgram* get_draw_program() { return &m_draw_program; };
+    bool const get_supported() const { return m_supported; };
+};
@@ -0,0 +1,83 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "RenderQueue.h"
+
+unsigned long long RenderQueue::make_key(RenderLayer layer, GLuint program_id, GLuint texture_id, float depth)
+{
+    // depth runs over the ortho near/far range [-1, 1]; larger z is drawn first
+    float normalised = (1.0f - depth) * 0.5f;
+    if (normalised < 0.0f) normalised = 0.0f;
+    if (normalised > 1.0f) normalised = 1.0f;
+    unsigned long long depth_bits = (unsigned long long) (normalised * ((1 << KEY_DEPTH_BITS) - 1));
+    
+    unsigned long long key = 0;
+    key |= ((unsigned long long) layer      & ((1ULL << KEY_LAYER_BITS) - 1))   << (KEY_PROGRAM_BITS + KEY_TEXTURE_BITS + KEY_DEPTH_BITS);
+    key |= ((unsigned long long) program_id & ((1ULL << KEY_PROGRAM_BITS) - 1)) << (KEY_TEXTURE_BITS + KEY_DEPTH_BITS);
+    key |= ((unsigned long long) texture_id & ((1ULL << KEY_TEXTURE_BITS) - 1)) << KEY_DEPTH_BITS;
+    key |= depth_bits;
+    return key;
+}
+
+void RenderQueue::submit(RenderLayer layer, ShaderProgram* program, GLuint texture_id, float depth, DrawCallback draw, void* data)
+{
+    RenderCommand command;
+    command.key     = make_key(layer, program->get_program_id(), texture_id, depth);
+    command.program = program;
+    command.draw    = draw;
+    command.data    = data;
+    m_commands.push_back(command);
+}
+
+void RenderQueue::radix_sort()
+{
+    size_t count = m_commands.size();
+    
+    m_keys.resize(count);
+    m_keys_scratch.resize(count);
+    m_order.resize(count);
+    m_order_scratch.resize(count);
+    
+    for (size_t i = 0; i < count; i++) {
+        m_keys[i]  = m_commands[i].key;
+        m_order[i] = (unsigned int) i;
+    }
+    
+    // LSD radix sort, one byte per pass; stable, so submission order breaks ties
+    for (int shift = 0; shift < 64; shift += 8) {
+        unsigned int histogram[256] = {};
+        for (size_t i = 0; i < count; i++) histogram[(m_keys[i] >> shift) & 0xff]++;
+        
+        // every key shares this byte: the pass would be a plain copy
+        if (histogram[(m_keys[0] >> shift) & 0xff] == count) continue;
+        
+        unsigned int offset = 0;
+        for (int bucket = 0; bucket < 256; bucket++) {
+            unsigned int bucket_count = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_count;
+        }
+        
+        for (size_t i = 0; i < count; i++) {
+            unsigned int destination = histogram[(m_keys[i] >> shift) & 0xff]++;
+            m_keys_scratch[destination]  = m_keys[i];
+            m_order_scratch[destination] = m_order[i];
+        }
+        
+        m_keys.swap(m_keys_scratch);
+        m_order.swap(m_order_scratch);
+    }
+}
+
+void RenderQueue::flush()
+{
+    if (m_commands.empty()) return;
+    
+    radix_sort();
+    
+    for (size_t i = 0; i < m_order.size(); i++) {
+        const RenderCommand& command = m_commands[m_order[i]];
+        command.draw(command.program, command.data);
+    }
+    
+    m_commands.clear();
+}
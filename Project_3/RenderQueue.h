@@ -0,0 +1,55 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "ShaderProgram.h"
+
+// draw order, back to front; exhaust sits behind the lander it comes out of
+enum RenderLayer { LAYER_BACKGROUND, LAYER_TERRAIN, LAYER_EFFECTS, LAYER_ACTORS, LAYER_HUD };
+
+typedef void (*DrawCallback)(ShaderProgram* program, void* data);
+
+// ————— SORT KEY ————— //
+// | layer: 8 | program: 12 | texture: 20 | depth: 24 |
+// Sorting by key groups draws sharing a program and texture inside a layer,
+// so GLState sees the fewest possible binds.
+const int KEY_DEPTH_BITS   = 24;
+const int KEY_TEXTURE_BITS = 20;
+const int KEY_PROGRAM_BITS = 12;
+const int KEY_LAYER_BITS   = 8;
+
+struct RenderCommand
+{
+    unsigned long long key;
+    ShaderProgram*     program;
+    DrawCallback       draw;
+    void*              data;
+};
+
+class RenderQueue
+{
+private:
+    std::vector<RenderCommand> m_commands;
+    
+    // (key, command index) pairs ping-ponged by the radix passes; kept between frames
+    std::vector<unsigned long long> m_keys;
+    std::vector<unsigned long long> m_keys_scratch;
+    std::vector<unsigned int>       m_order;
+    std::vector<unsigned int>       m_order_scratch;
+    
+    void radix_sort();
+    
+public:
+    static unsigned long long make_key(RenderLayer layer, GLuint program_id, GLuint texture_id, float depth);
+    
+    void submit(RenderLayer layer, ShaderProgram* program, GLuint texture_id, float depth, DrawCallback draw, void* data);
+    
+    // sorts everything submitted this frame, draws it and empties the queue
+    void flush();
+    
+    int const get_command_count() const { return (int) m_commands.size(); };
+};
@@ -0,0 +1,70 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "RenderTarget.h"
+#include "GLState.h"
+#include <cstdio>
+
+bool RenderTarget::create(int width, int height, GLint filter)
+{
+    m_width  = width;
+    m_height = height;
+    
+    glGenTextures(1, &m_texture_id);
+    GLState::bind_texture(m_texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_texture_id, 0);
+    
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+    {
+        printf("Error creating %dx%d render target (status 0x%x)!\n", width, height, status);
+        destroy();
+        return false;
+    }
+    
+    return true;
+}
+
+void RenderTarget::destroy()
+{
+    if (m_framebuffer != 0) glDeleteFramebuffers(1, &m_framebuffer);
+    if (m_texture_id != 0)  glDeleteTextures(1, &m_texture_id);
+    
+    // the deleted texture may still be what GLState thinks is bound
+    GLState::invalidate();
+    
+    m_framebuffer = m_texture_id = 0;
+    m_width = m_height = 0;
+}
+
+void RenderTarget::resize(int width, int height)
+{
+    if (width == m_width && height == m_height) return;
+    
+    m_width  = width;
+    m_height = height;
+    
+    GLState::bind_texture(m_texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+}
+
+void RenderTarget::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glViewport(0, 0, m_width, m_height);
+}
+
+void RenderTarget::bind_default(int viewport_width, int viewport_height)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(0, 0, viewport_width, viewport_height);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+
+// An offscreen colour buffer: a framebuffer object with one RGBA texture attached.
+class RenderTarget
+{
+private:
+    GLuint m_framebuffer = 0;
+    GLuint m_texture_id  = 0;
+    int    m_width       = 0;
+    int    m_height      = 0;
+    
+public:
+    // returns false if the driver rejects the framebuffer; filter applies when the texture is scaled
+    bool create(int width, int height, GLint filter = GL_NEAREST);
+    void destroy();
+    
+    // reallocates the colour texture only when the size actually changes
+    void resize(int width, int height);
+    
+    // subsequent draws land in this target; also sets the viewport to cover it
+    void bind();
+    static void bind_default(int viewport_width, int viewport_height);
+    
+    GLuint const get_texture_id()  const { return m_texture_id;       };
+    GLuint const get_framebuffer() const { return m_framebuffer;      };
+    int    const get_width()       const { return m_width;            };
+    int    const get_height()      const { return m_height;           };
+    bool   const is_valid()        const { return m_framebuffer != 0; };
+};
@@ -1,32 +1,59 @@
 #define GL_SILENCE_DEPRECATION
 
 #include "ShaderProgram.h"
+#include "TransformFeedback.h"
 
-void ShaderProgram::load(const char *vertex_shader_file, const char *fragment_shader_file) {
+glm::mat4    ShaderProgram::s_view_matrix            = glm::mat4(1.0f);
+glm::mat4    ShaderProgram::s_projection_matrix      = glm::mat4(1.0f);
+glm::mat4    ShaderProgram::s_view_projection_matrix = glm::mat4(1.0f);
+unsigned int ShaderProgram::s_camera_revision        = 1;
+const AssetPack* ShaderProgram::s_asset_pack         = NULL;
+
+void ShaderProgram::load(const char *vertex_shader_file, const char *fragment_shader_file,
+                         const char *const *feedback_varyings, int feedback_varying_count) {
     
-    // create the vertex shader
-    m_vertex_shader = load_shader_from_file(vertex_shader_file, GL_VERTEX_SHADER);
-    // create the fragment shader
-    m_fragment_shader = load_shader_from_file(fragment_shader_file, GL_FRAGMENT_SHADER);
+    std::string vertex_source   = read_shader_file(vertex_shader_file);
+    std::string fragment_source = read_shader_file(fragment_shader_file);
     
-    // Create the final shader program from our vertex and fragment shaders
-    m_program_id = glCreateProgram();
-    glAttachShader(m_program_id, m_vertex_shader);
-    glAttachShader(m_program_id, m_fragment_shader);
-    glLinkProgram(m_program_id);
+    // the cached binary sits next to the vertex shader, named for everything that went into
+    // the link, and is only valid for these exact sources and varyings on this exact driver
+    std::string cache_file = program_binary_file(vertex_shader_file, fragment_shader_file, feedback_varyings, feedback_varying_count);
+    unsigned long long cache_key = program_binary_key(vertex_source, fragment_source, feedback_varyings, feedback_varying_count);
     
-    GLint link_success;
-    glGetProgramiv(m_program_id, GL_LINK_STATUS, &link_success);
+    m_program_id    = glCreateProgram();
+    m_vertex_shader = m_fragment_shader = 0;
     
-    if(link_success == GL_FALSE)
+    if (!load_program_binary(cache_file, cache_key))
     {
-        printf("Error linking shader program!\n");
+        // create the vertex shader
+        m_vertex_shader = load_shader_from_string(vertex_source, GL_VERTEX_SHADER);
+        // create the fragment shader
+        m_fragment_shader = load_shader_from_string(fragment_source, GL_FRAGMENT_SHADER);
+        
+        // Create the final shader program from our vertex and fragment shaders
+        glAttachShader(m_program_id, m_vertex_shader);
+        glAttachShader(m_program_id, m_fragment_shader);
+        if (feedback_varying_count > 0) {
+            TransformFeedback::set_varyings(m_program_id, feedback_varying_count, feedback_varyings);
+        }
+#ifdef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+        if (program_binaries_supported()) glProgramParameteri(m_program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+        glLinkProgram(m_program_id);
+        
+        GLint link_success;
+        glGetProgramiv(m_program_id, GL_LINK_STATUS, &link_success);
+        
+        if(link_success == GL_FALSE)
+        {
+            printf("Error linking shader program!\n");
+        }
+        else save_program_binary(cache_file, cache_key);
     }
     
-    m_model_matrix_uniform      = glGetUniformLocation(m_program_id, "modelMatrix");
-    m_projection_matrix_uniform = glGetUniformLocation(m_program_id, "projectionMatrix");
-    m_view_matrix_uniform       = glGetUniformLocation(m_program_id, "viewMatrix");
-    m_colour_uniform            = glGetUniformLocation(m_program_id, "color");
+    m_model_matrix_uniform           = glGetUniformLocation(m_program_id, "modelMatrix");
+    m_view_projection_matrix_uniform = glGetUniformLocation(m_program_id, "viewProjectionMatrix");
+    m_colour_uniform                 = glGetUniformLocation(m_program_id, "color");
     
     m_position_attribute  = glGetAttribLocation(m_program_id, "position");
     m_tex_coord_attribute = glGetAttribLocation(m_program_id, "texCoord");
@@ -42,8 +69,12 @@ void ShaderProgram::cleanup()
     glDeleteShader(m_fragment_shader);
 }
 
-GLuint ShaderProgram::load_shader_from_file(const std::string &shaderFile, GLenum type)
+std::string ShaderProgram::read_shader_file(const std::string &shaderFile)
 {
+    size_t packed_size;
+    const unsigned char* packed = s_asset_pack != NULL ? s_asset_pack->find(shaderFile.c_str(), &packed_size) : NULL;
+    if (packed != NULL) return std::string((const char*) packed, packed_size);
+    
     //Open a file stream with the file name
     std::ifstream infile(shaderFile);
     
@@ -55,8 +86,118 @@ GLuint ShaderProgram::load_shader_from_file(const std::string &shaderFile, GLenu
     std::stringstream buffer;
     buffer << infile.rdbuf();
     
-    // Load the shader from the contents of the file
-    return load_shader_from_string(buffer.str(), type);
+    return buffer.str();
+}
+
+bool ShaderProgram::program_binaries_supported()
+{
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+#ifdef _WINDOWS
+    if (!GLEW_ARB_get_program_binary) return false;
+#endif
+    // a GL 2.1 context rejects the enum and leaves this at zero
+    GLint format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+    glGetError();
+    return format_count > 0;
+#else
+    return false;
+#endif
+}
+
+// FNV-1a, with a separator after each string so ("ab", "c") and ("a", "bc") differ
+static void mix_program_binary_hash(unsigned long long &hash, const char *bytes, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char) bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    hash ^= 0xff;
+    hash *= 1099511628211ULL;
+}
+
+std::string ShaderProgram::program_binary_file(const char *vertex_shader_file, const char *fragment_shader_file,
+                                               const char *const *feedback_varyings, int feedback_varying_count)
+{
+    // programs sharing a vertex shader each get their own file
+    unsigned long long hash = 14695981039346656037ULL;
+    mix_program_binary_hash(hash, fragment_shader_file, strlen(fragment_shader_file));
+    for (int i = 0; i < feedback_varying_count; i++) mix_program_binary_hash(hash, feedback_varyings[i], strlen(feedback_varyings[i]));
+    
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx", hash);
+    return std::string(vertex_shader_file) + suffix + PROGRAM_BINARY_EXTENSION;
+}
+
+unsigned long long ShaderProgram::program_binary_key(const std::string &vertex_source, const std::string &fragment_source,
+                                                     const char *const *feedback_varyings, int feedback_varying_count)
+{
+    // both sources, the captured varyings and the driver identification strings
+    unsigned long long hash = 14695981039346656037ULL;
+    mix_program_binary_hash(hash, vertex_source.data(), vertex_source.size());
+    mix_program_binary_hash(hash, fragment_source.data(), fragment_source.size());
+    for (int i = 0; i < feedback_varying_count; i++) mix_program_binary_hash(hash, feedback_varyings[i], strlen(feedback_varyings[i]));
+    
+    const GLenum driver_strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (GLenum name : driver_strings) {
+        const char *value = (const char *) glGetString(name);
+        if (value != NULL) mix_program_binary_hash(hash, value, strlen(value));
+    }
+    
+    return hash;
+}
+
+bool ShaderProgram::load_program_binary(const std::string &cache_file, unsigned long long cache_key)
+{
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+    if (!program_binaries_supported()) return false;
+    
+    std::ifstream infile(cache_file, std::ios::binary);
+    if (infile.fail()) return false;
+    
+    ProgramBinaryHeader header;
+    infile.read((char *) &header, sizeof(header));
+    if (!infile || header.magic != PROGRAM_BINARY_MAGIC || header.key != cache_key || header.length <= 0) return false;
+    
+    std::vector<char> binary(header.length);
+    infile.read(binary.data(), header.length);
+    if (!infile) return false;
+    
+    glProgramBinary(m_program_id, header.format, binary.data(), header.length);
+    
+    // the driver may still refuse it (e.g. after an update that kept the version string)
+    GLint link_success;
+    glGetProgramiv(m_program_id, GL_LINK_STATUS, &link_success);
+    return link_success == GL_TRUE;
+#else
+    return false;
+#endif
+}
+
+void ShaderProgram::save_program_binary(const std::string &cache_file, unsigned long long cache_key)
+{
+#ifdef GL_NUM_PROGRAM_BINARY_FORMATS
+    if (!program_binaries_supported()) return;
+    
+    GLint length = 0;
+    glGetProgramiv(m_program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    
+    ProgramBinaryHeader header;
+    header.magic  = PROGRAM_BINARY_MAGIC;
+    header.key    = cache_key;
+    header.format = 0;
+    
+    std::vector<char> binary(length);
+    glGetProgramBinary(m_program_id, length, &header.length, &header.format, binary.data());
+    if (header.length <= 0) return;
+    
+    std::ofstream outfile(cache_file, std::ios::binary | std::ios::trunc);
+    if (outfile.fail()) return;
+    
+    outfile.write((const char *) &header, sizeof(header));
+    outfile.write(binary.data(), header.length);
+#endif
 }
 
 GLuint ShaderProgram::load_shader_from_string(const std::string &shaderContents, GLenum type)
@@ -90,24 +231,54 @@ GLuint ShaderProgram::load_shader_from_string(const std::string &shaderContents,
 
 void ShaderProgram::set_colour(float red, float green, float blue, float alpha)
 {
-    glUseProgram(m_program_id);
+    glm::vec4 colour = glm::vec4(red, green, blue, alpha);
+    if (m_colour_set && m_colour == colour) { GLState::count_skipped(); return; }
+    
+    GLState::use_program(m_program_id);
     glUniform4f(m_colour_uniform, red, green, blue, alpha);
+    GLState::count_issued();
+    m_colour = colour;
+    m_colour_set = true;
 }
 
 void ShaderProgram::set_view_matrix(const glm::mat4 &matrix)
 {
-    glUseProgram(m_program_id);
-    glUniformMatrix4fv(m_view_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    if (s_view_matrix == matrix) return;
+    
+    s_view_matrix = matrix;
+    s_view_projection_matrix = s_projection_matrix * s_view_matrix;
+    s_camera_revision++;
 }
 
-void ShaderProgram::set_model_matrix(const glm::mat4 &matrix)
+void ShaderProgram::set_projection_matrix(const glm::mat4 &matrix)
 {
-    glUseProgram(m_program_id);
-    glUniformMatrix4fv(m_model_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    if (s_projection_matrix == matrix) return;
+    
+    s_projection_matrix = matrix;
+    s_view_projection_matrix = s_projection_matrix * s_view_matrix;
+    s_camera_revision++;
 }
 
-void ShaderProgram::set_projection_matrix(const glm::mat4 &matrix)
+void ShaderProgram::sync_camera()
 {
-    glUseProgram(m_program_id);
-    glUniformMatrix4fv(m_projection_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    if (m_camera_revision == s_camera_revision) { GLState::count_skipped(); return; }
+    
+    GLState::use_program(m_program_id);
+    glUniformMatrix4fv(m_view_projection_matrix_uniform, 1, GL_FALSE, &s_view_projection_matrix[0][0]);
+    GLState::count_issued();
+    m_camera_revision = s_camera_revision;
+}
+
+void ShaderProgram::set_model_matrix(const glm::mat4 &matrix)
+{
+    // every draw sets its model matrix, so this is where a stale camera gets caught up
+    sync_camera();
+    
+    if (m_model_matrix_set && m_model_matrix == matrix) { GLState::count_skipped(); return; }
+    
+    GLState::use_program(m_program_id);
+    glUniformMatrix4fv(m_model_matrix_uniform, 1, GL_FALSE, &matrix[0][0]);
+    GLState::count_issued();
+    m_model_matrix = matrix;
+    m_model_matrix_set = true;
 }
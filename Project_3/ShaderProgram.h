@@ -9,7 +9,24 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <cstring>
+#include <cstdio>
 #include "glm/mat4x4.hpp"
+#include "GLState.h"
+#include "AssetPack.h"
+
+const char PROGRAM_BINARY_EXTENSION[] = ".bin";
+const unsigned int PROGRAM_BINARY_MAGIC = 0x42504C47; // "GLPB"
+
+// precedes the driver blob in a cached program binary
+struct ProgramBinaryHeader
+{
+    unsigned int       magic;
+    unsigned long long key;
+    GLenum             format;
+    GLint              length;
+};
 
 class ShaderProgram
 {
@@ -17,13 +34,21 @@ private:
     void cleanup();
     
     GLuint load_shader_from_string(const std::string &shader_contents, GLenum shader_type);
-    GLuint load_shader_from_file(const std::string &shader_file, GLenum shader_type);
+    std::string read_shader_file(const std::string &shader_file);
+    
+    // ————— PROGRAM BINARY CACHE ————— //
+    static bool program_binaries_supported();
+    static std::string program_binary_file(const char *vertex_shader_file, const char *fragment_shader_file,
+                                           const char *const *feedback_varyings, int feedback_varying_count);
+    static unsigned long long program_binary_key(const std::string &vertex_source, const std::string &fragment_source,
+                                                 const char *const *feedback_varyings, int feedback_varying_count);
+    bool load_program_binary(const std::string &cache_file, unsigned long long cache_key);
+    void save_program_binary(const std::string &cache_file, unsigned long long cache_key);
 
     GLuint m_program_id;
 
-    GLuint m_projection_matrix_uniform;
+    GLuint m_view_projection_matrix_uniform;
     GLuint m_model_matrix_uniform;
-    GLuint m_view_matrix_uniform;
     GLuint m_colour_uniform;
 
     GLuint m_position_attribute;
@@ -32,18 +57,46 @@ private:
     GLuint m_vertex_shader;
     GLuint m_fragment_shader;
     
+    // last values uploaded, so unchanged uniforms are not re-sent
+    glm::mat4 m_model_matrix;
+    glm::vec4 m_colour;
+    bool m_model_matrix_set = false;
+    bool m_colour_set       = false;
+    
+    // ————— CAMERA ————— //
+    // one camera shared by every program; view * projection is multiplied once here
+    // instead of per vertex, and each program re-uploads it only when it has changed
+    static glm::mat4 s_view_matrix;
+    static glm::mat4 s_projection_matrix;
+    static glm::mat4 s_view_projection_matrix;
+    static unsigned int s_camera_revision;
+    unsigned int m_camera_revision = 0;
+    
+    void sync_camera();
+    
+    // shader sources are looked up here first, then on disk
+    static const AssetPack* s_asset_pack;
+    
 public:
 
-    void load(const char *vertex_shader_file, const char *fragment_shader_file);
+    // feedback_varyings: outputs captured by transform feedback, interleaved; must be known before linking
+    void load(const char *vertex_shader_file, const char *fragment_shader_file,
+              const char *const *feedback_varyings = NULL, int feedback_varying_count = 0);
 
     void set_model_matrix(const glm::mat4 &matrix);
-    void set_projection_matrix(const glm::mat4 &matrix);
-    void set_view_matrix(const glm::mat4 &matrix);
+    static void set_projection_matrix(const glm::mat4 &matrix);
+    static void set_view_matrix(const glm::mat4 &matrix);
+    static void set_asset_pack(const AssetPack* pack) { s_asset_pack = pack; };
     void set_colour(float red, float green, float blue, float alpha);
     
     GLuint const get_program_id()               const { return m_program_id;          };
     GLuint const get_position_attribute()       const { return m_position_attribute;  };
     GLuint const get_tex_coordinate_attribute() const { return m_tex_coord_attribute; };
     
+    static glm::mat4 const get_view_matrix()            { return s_view_matrix;            };
+    static glm::mat4 const get_projection_matrix()      { return s_projection_matrix;      };
+    static glm::mat4 const get_view_projection_matrix() { return s_view_projection_matrix; };
+    static unsigned int const get_camera_revision()     { return s_camera_revision;        };
+    
     void set_program_id(GLuint program_id)                         { m_program_id = program_id;                   };
 };
@@ -0,0 +1,322 @@
+#include "SoftwareRenderer.h"
+#include "FontBank.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/matrix_inverse.hpp"
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define SOFTWARE_BLEND_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define SOFTWARE_BLEND_NEON
+#endif
+
+const int TILE_SIZE = 64;
+const float LOCAL_EDGE = 0.5f + 1e-4f;
+
+// ————— BLENDING ————— //
+// x / 255, rounded, exact for every x <= 255 * 255
+static inline unsigned int divide_by_255(unsigned int x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+static inline unsigned int blend_pixel(unsigned int destination, unsigned int source)
+{
+    unsigned int alpha = source >> 24;
+    if (alpha == 255) return source;
+    if (alpha == 0)   return destination;
+    
+    unsigned int result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        unsigned int s = (source >> shift) & 0xff;
+        unsigned int d = (destination >> shift) & 0xff;
+        result |= divide_by_255(s * alpha + d * (255 - alpha)) << shift;
+    }
+    return result;
+}
+
+void blend_span(unsigned int* destination, const unsigned int* source, int count)
+{
+    int i = 0;
+    
+#if defined(SOFTWARE_BLEND_SSE2)
+    // four pixels per step, widened to 16-bit lanes two pixels at a time
+    const __m128i zero    = _mm_setzero_si128();
+    const __m128i max     = _mm_set1_epi16(255);
+    const __m128i rounder = _mm_set1_epi16(128);
+    
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*) (source + i));
+        __m128i d = _mm_loadu_si128((const __m128i*) (destination + i));
+        
+        // whole span opaque or whole span empty: no arithmetic needed
+        int alpha_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_srli_epi32(s, 24), _mm_set1_epi32(255)));
+        if (alpha_mask == 0xffff) { _mm_storeu_si128((__m128i*) (destination + i), s); continue; }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(s, 24), zero)) == 0xffff) continue;
+        
+        __m128i s_lo = _mm_unpacklo_epi8(s, zero), s_hi = _mm_unpackhi_epi8(s, zero);
+        __m128i d_lo = _mm_unpacklo_epi8(d, zero), d_hi = _mm_unpackhi_epi8(d, zero);
+        
+        __m128i a_lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        __m128i a_hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s_hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        
+        __m128i t_lo = _mm_add_epi16(_mm_mullo_epi16(s_lo, a_lo), _mm_mullo_epi16(d_lo, _mm_sub_epi16(max, a_lo)));
+        __m128i t_hi = _mm_add_epi16(_mm_mullo_epi16(s_hi, a_hi), _mm_mullo_epi16(d_hi, _mm_sub_epi16(max, a_hi)));
+        
+        t_lo = _mm_add_epi16(t_lo, rounder);
+        t_hi = _mm_add_epi16(t_hi, rounder);
+        t_lo = _mm_srli_epi16(_mm_add_epi16(t_lo, _mm_srli_epi16(t_lo, 8)), 8);
+        t_hi = _mm_srli_epi16(_mm_add_epi16(t_hi, _mm_srli_epi16(t_hi, 8)), 8);
+        
+        _mm_storeu_si128((__m128i*) (destination + i), _mm_packus_epi16(t_lo, t_hi));
+    }
+#elif defined(SOFTWARE_BLEND_NEON)
+    // eight pixels per step, channels de-interleaved by the load
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t s = vld4_u8((const uint8_t*) (source + i));
+        uint8x8x4_t d = vld4_u8((const uint8_t*) (destination + i));
+        uint8x8_t alpha     = s.val[3];
+        uint8x8_t one_minus = vmvn_u8(alpha);
+        
+        for (int channel = 0; channel < 4; channel++) {
+            uint16x8_t t = vmlal_u8(vmull_u8(s.val[channel], alpha), d.val[channel], one_minus);
+            t = vaddq_u16(t, vdupq_n_u16(128));
+            d.val[channel] = vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+        }
+        vst4_u8((uint8_t*) (destination + i), d);
+    }
+#endif
+    
+    for (; i < count; i++) destination[i] = blend_pixel(destination[i], source[i]);
+}
+
+// ————— SETUP ————— //
+void SoftwareRenderer::create(int width, int height, int thread_count)
+{
+    destroy();
+    
+    m_width  = width;
+    m_height = height;
+    m_colour.assign(width * height, 0);
+    
+    int tiles_across = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+    int tiles_down   = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+    m_tile_count = tiles_across * tiles_down;
+    
+    // more workers than tiles would only ever sleep
+    thread_count = std::max(1, std::min(thread_count, m_tile_count));
+    m_spans.assign(thread_count, std::vector<unsigned int>(TILE_SIZE));
+    
+    m_stopping = false;
+    // workers only answer flushes started after this point
+    for (int i = 1; i < thread_count; i++) m_workers.push_back(std::thread(&SoftwareRenderer::worker_loop, this, i, m_flush_count));
+}
+
+void SoftwareRenderer::destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) worker.join();
+    m_workers.clear();
+}
+
+void SoftwareRenderer::clear(float red, float green, float blue, float alpha)
+{
+    unsigned int colour = (unsigned int) (red * 255.0f + 0.5f)
+                        | (unsigned int) (green * 255.0f + 0.5f) << 8
+                        | (unsigned int) (blue * 255.0f + 0.5f) << 16
+                        | (unsigned int) (alpha * 255.0f + 0.5f) << 24;
+    std::fill(m_colour.begin(), m_colour.end(), colour);
+}
+
+// ————— RECORDING ————— //
+void SoftwareRenderer::submit_quad(const glm::mat4& model_matrix, const SoftwareTexture* texture, float u0, float v0, float u1, float v1)
+{
+    if (texture == NULL || texture->width == 0) return;
+    
+    // local -> clip, assuming an affine (orthographic) camera, then clip -> pixels
+    glm::mat4 local_to_clip = m_view_projection * model_matrix;
+    float half_width  = m_width * 0.5f;
+    float half_height = m_height * 0.5f;
+    
+    glm::mat3 local_to_screen;
+    local_to_screen[0] = glm::vec3(half_width * local_to_clip[0][0], half_height * local_to_clip[0][1], 0.0f);
+    local_to_screen[1] = glm::vec3(half_width * local_to_clip[1][0], half_height * local_to_clip[1][1], 0.0f);
+    local_to_screen[2] = glm::vec3(half_width * (local_to_clip[3][0] + 1.0f), half_height * (local_to_clip[3][1] + 1.0f), 1.0f);
+    
+    if (glm::determinant(local_to_screen) == 0.0f) return;
+    
+    float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    const glm::vec2 corners[] = { glm::vec2(-0.5f, -0.5f), glm::vec2(0.5f, -0.5f), glm::vec2(0.5f, 0.5f), glm::vec2(-0.5f, 0.5f) };
+    for (const glm::vec2& corner : corners) {
+        glm::vec3 screen = local_to_screen * glm::vec3(corner, 1.0f);
+        min_x = fminf(min_x, screen.x);
+        min_y = fminf(min_y, screen.y);
+        max_x = fmaxf(max_x, screen.x);
+        max_y = fmaxf(max_y, screen.y);
+    }
+    
+    // a pixel is covered when its centre is, as in GL
+    SoftwareSprite sprite;
+    sprite.min_x = std::max(0, (int) ceilf(min_x - 0.5f));
+    sprite.min_y = std::max(0, (int) ceilf(min_y - 0.5f));
+    sprite.max_x = std::min(m_width,  (int) ceilf(max_x - 0.5f));
+    sprite.max_y = std::min(m_height, (int) ceilf(max_y - 0.5f));
+    if (sprite.min_x >= sprite.max_x || sprite.min_y >= sprite.max_y) return;
+    
+    sprite.texture = texture;
+    sprite.screen_to_local = glm::inverse(local_to_screen);
+    sprite.u0 = u0;
+    sprite.v0 = v0;
+    sprite.u1 = u1;
+    sprite.v1 = v1;
+    m_sprites.push_back(sprite);
+}
+
+void SoftwareRenderer::draw_sprite(const glm::mat4& model_matrix, const SoftwareTexture* texture)
+{
+    submit_quad(model_matrix, texture, 0.0f, 0.0f, 1.0f, 1.0f);
+}
+
+void SoftwareRenderer::draw_text(const SoftwareTexture* font, const std::string& text, float screen_size, float spacing, glm::vec3 position)
+{
+    float width  = 1.0f / FONTBANK_SIZE;
+    float height = 1.0f / FONTBANK_SIZE;
+    
+    for (int i = 0; i < text.size(); i++) {
+        int spritesheet_index = (int) text[i];
+        float offset = (screen_size + spacing) * i;
+        
+        float u_coordinate = (float) (spritesheet_index % FONTBANK_SIZE) / FONTBANK_SIZE;
+        float v_coordinate = (float) (spritesheet_index / FONTBANK_SIZE) / FONTBANK_SIZE;
+        
+        glm::mat4 model_matrix = glm::translate(glm::mat4(1.0f), position + glm::vec3(offset, 0.0f, 0.0f));
+        model_matrix = glm::scale(model_matrix, glm::vec3(screen_size, screen_size, 1.0f));
+        
+        submit_quad(model_matrix, font, u_coordinate, v_coordinate, u_coordinate + width, v_coordinate + height);
+    }
+}
+
+// ————— RASTERIZING ————— //
+void SoftwareRenderer::rasterize_tile(int tile, std::vector<unsigned int>& span)
+{
+    int tiles_across = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+    int tile_min_x = (tile % tiles_across) * TILE_SIZE;
+    int tile_min_y = (tile / tiles_across) * TILE_SIZE;
+    int tile_max_x = std::min(tile_min_x + TILE_SIZE, m_width);
+    int tile_max_y = std::min(tile_min_y + TILE_SIZE, m_height);
+    
+    for (const SoftwareSprite& sprite : m_sprites) {
+        int min_x = std::max(sprite.min_x, tile_min_x);
+        int max_x = std::min(sprite.max_x, tile_max_x);
+        int min_y = std::max(sprite.min_y, tile_min_y);
+        int max_y = std::min(sprite.max_y, tile_max_y);
+        if (min_x >= max_x || min_y >= max_y) continue;
+        
+        const SoftwareTexture* texture = sprite.texture;
+        glm::vec3 step = sprite.screen_to_local[0];
+        float u_scale = (sprite.u1 - sprite.u0) * texture->width;
+        float v_scale = (sprite.v1 - sprite.v0) * texture->height;
+        float u_start = sprite.u0 * texture->width;
+        float v_start = sprite.v0 * texture->height;
+        
+        for (int y = min_y; y < max_y; y++) {
+            glm::vec3 local = sprite.screen_to_local * glm::vec3(min_x + 0.5f, y + 0.5f, 1.0f);
+            
+            // gather the span with nearest sampling, GL_REPEAT wrapping
+            for (int x = 0; x < max_x - min_x; x++, local += step) {
+                if (fabsf(local.x) > LOCAL_EDGE || fabsf(local.y) > LOCAL_EDGE) { span[x] = 0; continue; }
+                
+                int texel_x = (int) floorf(u_start + (local.x + 0.5f) * u_scale) % texture->width;
+                int texel_y = (int) floorf(v_start + (0.5f - local.y) * v_scale) % texture->height;
+                if (texel_x < 0) texel_x += texture->width;
+                if (texel_y < 0) texel_y += texture->height;
+                
+                span[x] = texture->pixels[texel_y * texture->width + texel_x];
+            }
+            
+            blend_span(&m_colour[y * m_width + min_x], span.data(), max_x - min_x);
+        }
+    }
+}
+
+// tiles never share pixels, so workers just pull the next free tile
+void SoftwareRenderer::rasterize_tiles(int worker)
+{
+    for (int tile = m_next_tile++; tile < m_tile_count; tile = m_next_tile++) rasterize_tile(tile, m_spans[worker]);
+}
+
+void SoftwareRenderer::worker_loop(int worker, unsigned int flushes_seen)
+{
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, flushes_seen] { return m_stopping || m_flush_count != flushes_seen; });
+            if (m_stopping) return;
+            flushes_seen = m_flush_count;
+        }
+        
+        rasterize_tiles(worker);
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy_workers == 0) m_finished.notify_one();
+    }
+}
+
+void SoftwareRenderer::flush()
+{
+    m_next_tile = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy_workers = (int) m_workers.size();
+        m_flush_count++;
+    }
+    m_wake.notify_all();
+    
+    rasterize_tiles(0);
+    
+    // every tile is claimed by now, but others may still be drawing theirs
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [this] { return m_busy_workers == 0; });
+    
+    m_sprites.clear();
+}
+
+bool SoftwareRenderer::write_tga(const std::string& filename) const
+{
+    FILE* file = fopen(filename.c_str(), "wb");
+    if (file == NULL) return false;
+    
+    // uncompressed true-colour, 32 bpp, 8 alpha bits, origin bottom-left
+    unsigned char header[18] = {};
+    header[2]  = 2;
+    header[12] = m_width & 0xff;
+    header[13] = (m_width >> 8) & 0xff;
+    header[14] = m_height & 0xff;
+    header[15] = (m_height >> 8) & 0xff;
+    header[16] = 32;
+    header[17] = 8;
+    fwrite(header, 1, sizeof(header), file);
+    
+    // RGBA -> BGRA, one row at a time
+    std::vector<unsigned int> row(m_width);
+    for (int y = 0; y < m_height; y++) {
+        const unsigned int* source = &m_colour[y * m_width];
+        for (int x = 0; x < m_width; x++) {
+            unsigned int pixel = source[x];
+            row[x] = (pixel & 0xff00ff00) | ((pixel & 0xff) << 16) | ((pixel >> 16) & 0xff);
+        }
+        fwrite(row.data(), sizeof(unsigned int), m_width, file);
+    }
+    
+    fclose(file);
+    return true;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "glm/mat4x4.hpp"
+#include "glm/mat3x3.hpp"
+
+// an RGBA8 image in CPU memory, rows top to bottom as AssetLoader decodes them
+struct SoftwareTexture
+{
+    int width  = 0;
+    int height = 0;
+    std::vector<unsigned int> pixels;
+};
+
+// one textured quad, already mapped to pixel space
+struct SoftwareSprite
+{
+    const SoftwareTexture* texture;
+    
+    // pixel centre -> quad-local coordinates in [-0.5, 0.5]
+    glm::mat3 screen_to_local;
+    
+    // clipped pixel bounds, max exclusive
+    int min_x, min_y, max_x, max_y;
+    
+    // texture rectangle the quad shows; (u0, v0) is its top-left
+    float u0, v0, u1, v1;
+};
+
+// Draws what Entity::render and DrawText draw, with no GL involved: nearest sampling,
+// SRC_ALPHA / ONE_MINUS_SRC_ALPHA blending. Draws are recorded, then flush() rasterizes
+// them tile by tile across threads, keeping submission order within every tile. The worker
+// threads are started by create() and sleep between flushes, so a frame only wakes them.
+class SoftwareRenderer
+{
+private:
+    int m_width  = 0;
+    int m_height = 0;
+    std::vector<unsigned int> m_colour; // bottom row first, like a GL framebuffer
+    
+    glm::mat4 m_view_projection = glm::mat4(1.0f);
+    std::vector<SoftwareSprite> m_sprites;
+    
+    // scratch row per worker for the sampled texels of one span
+    std::vector<std::vector<unsigned int>> m_spans;
+    
+    // ————— WORKERS ————— //
+    // worker i rasterizes with m_spans[i]; the thread calling flush() is worker 0
+    std::vector<std::thread> m_workers;
+    std::mutex               m_mutex;
+    std::condition_variable  m_wake;      // a flush started, or destroy() was called
+    std::condition_variable  m_finished;  // the last busy worker ran out of tiles
+    unsigned int             m_flush_count = 0;
+    int                      m_busy_workers = 0;
+    bool                     m_stopping     = false;
+    std::atomic<int>         m_next_tile;
+    int                      m_tile_count = 0;
+    
+    void submit_quad(const glm::mat4& model_matrix, const SoftwareTexture* texture, float u0, float v0, float u1, float v1);
+    void rasterize_tile(int tile, std::vector<unsigned int>& span);
+    void rasterize_tiles(int worker);
+    void worker_loop(int worker, unsigned int flushes_seen);
+    
+public:
+    ~SoftwareRenderer() { destroy(); };
+    
+    // thread_count includes the thread that calls flush()
+    void create(int width, int height, int thread_count);
+    void destroy();
+    
+    void set_view_projection(const glm::mat4& view_projection) { m_view_projection = view_projection; };
+    void clear(float red, float green, float blue, float alpha);
+    
+    // counterparts of Entity::render and DrawText
+    void draw_sprite(const glm::mat4& model_matrix, const SoftwareTexture* texture);
+    void draw_text(const SoftwareTexture* font, const std::string& text, float screen_size, float spacing, glm::vec3 position);
+    
+    void flush();
+    
+    bool write_tga(const std::string& filename) const;
+    
+    const unsigned int* get_pixels() const { return m_colour.data(); };
+    int const get_width()            const { return m_width;  };
+    int const get_height()           const { return m_height; };
+};
+
+// dst = src * src.a + dst * (1 - src.a) on every channel, for count pixels
+void blend_span(unsigned int* destination, const unsigned int* source, int count);
@@ -0,0 +1,136 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "TileMap.h"
+#include "GLState.h"
+#include <algorithm>
+
+const GLsizei TILE_VERTEX_STRIDE = 4 * sizeof(float);
+
+void TileMap::create(int columns, int rows, glm::vec2 origin, glm::vec2 tile_size, int atlas_columns, int atlas_rows)
+{
+    destroy();
+
+    m_columns       = columns;
+    m_rows          = rows;
+    m_origin        = origin;
+    m_tile_size     = tile_size;
+    m_atlas_columns = atlas_columns;
+    m_atlas_rows    = atlas_rows;
+
+    m_chunk_columns = (columns + CHUNK_COLUMNS - 1) / CHUNK_COLUMNS;
+    m_chunk_rows    = (rows + CHUNK_ROWS - 1) / CHUNK_ROWS;
+
+    m_tiles.assign(columns * rows, EMPTY_TILE);
+    m_chunks.assign(m_chunk_columns * m_chunk_rows, TileChunk());
+    m_revision++;
+}
+
+void TileMap::destroy()
+{
+    for (int i = 0; i < m_chunks.size(); i++) {
+        if (m_chunks[i].vertex_buffer != 0) glDeleteBuffers(1, &m_chunks[i].vertex_buffer);
+    }
+    m_chunks.clear();
+    m_tiles.clear();
+    m_columns = m_rows = m_chunk_columns = m_chunk_rows = 0;
+
+    // a deleted name may be handed out again
+    GLState::invalidate();
+}
+
+void TileMap::set_tile(int column, int row, unsigned char tile)
+{
+    if (column < 0 || column >= m_columns || row < 0 || row >= m_rows) return;
+
+    unsigned char& current = m_tiles[row * m_columns + column];
+    if (current == tile) return;
+
+    current = tile;
+    m_chunks[(row / CHUNK_ROWS) * m_chunk_columns + (column / CHUNK_COLUMNS)].dirty = true;
+    m_revision++;
+}
+
+unsigned char const TileMap::get_tile(int column, int row) const
+{
+    if (column < 0 || column >= m_columns || row < 0 || row >= m_rows) return EMPTY_TILE;
+    return m_tiles[row * m_columns + column];
+}
+
+void TileMap::build_chunk(int chunk_x, int chunk_y)
+{
+    TileChunk& chunk = m_chunks[chunk_y * m_chunk_columns + chunk_x];
+
+    float atlas_width  = 1.0f / m_atlas_columns;
+    float atlas_height = 1.0f / m_atlas_rows;
+
+    int first_column = chunk_x * CHUNK_COLUMNS, last_column = std::min(first_column + CHUNK_COLUMNS, m_columns);
+    int first_row    = chunk_y * CHUNK_ROWS,    last_row    = std::min(first_row + CHUNK_ROWS, m_rows);
+
+    // interleaved x, y, u, v per vertex, in world space, same winding as Entity::render
+    m_scratch.clear();
+    for (int row = first_row; row < last_row; row++) {
+        for (int column = first_column; column < last_column; column++) {
+            unsigned char tile = m_tiles[row * m_columns + column];
+            if (tile == EMPTY_TILE) continue;
+
+            int atlas_index = tile - 1;
+            float u = (float) (atlas_index % m_atlas_columns) * atlas_width;
+            float v = (float) (atlas_index / m_atlas_columns) * atlas_height;
+
+            float left   = m_origin.x + column * m_tile_size.x, right = left + m_tile_size.x;
+            float bottom = m_origin.y + row * m_tile_size.y,    top   = bottom + m_tile_size.y;
+
+            m_scratch.insert(m_scratch.end(), {
+                left,  bottom, u,               v + atlas_height,
+                right, bottom, u + atlas_width, v + atlas_height,
+                right, top,    u + atlas_width, v,
+                left,  bottom, u,               v + atlas_height,
+                right, top,    u + atlas_width, v,
+                left,  top,    u,               v,
+            });
+        }
+    }
+
+    chunk.vertex_count = (int) (m_scratch.size() / 4);
+    chunk.dirty = false;
+    if (chunk.vertex_count == 0) return;
+
+    if (chunk.vertex_buffer == 0) glGenBuffers(1, &chunk.vertex_buffer);
+    GLState::bind_array_buffer(chunk.vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, m_scratch.size() * sizeof(float), m_scratch.data(), GL_STATIC_DRAW);
+}
+
+void TileMap::render(ShaderProgram* program, const glm::vec4& view_bounds)
+{
+    if (m_chunks.empty()) return;
+
+    // vertices are already in world space
+    program->set_model_matrix(glm::mat4(1.0f));
+    GLState::use_program(program->get_program_id());
+    GLState::bind_texture(texture_id);
+
+    float chunk_width  = CHUNK_COLUMNS * m_tile_size.x;
+    float chunk_height = CHUNK_ROWS * m_tile_size.y;
+
+    for (int chunk_y = 0; chunk_y < m_chunk_rows; chunk_y++) {
+        float bottom = m_origin.y + chunk_y * chunk_height;
+        if (bottom > view_bounds.w || bottom + chunk_height < view_bounds.z) continue;
+
+        for (int chunk_x = 0; chunk_x < m_chunk_columns; chunk_x++) {
+            float left = m_origin.x + chunk_x * chunk_width;
+            if (left > view_bounds.y || left + chunk_width < view_bounds.x) continue;
+
+            TileChunk& chunk = m_chunks[chunk_y * m_chunk_columns + chunk_x];
+            if (chunk.dirty) build_chunk(chunk_x, chunk_y);
+            if (chunk.vertex_count == 0) continue;
+
+            GLState::bind_array_buffer(chunk.vertex_buffer);
+            glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, TILE_VERTEX_STRIDE, (void*) 0);
+            GLState::enable_attribute(program->get_position_attribute());
+            glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, TILE_VERTEX_STRIDE, (void*) (2 * sizeof(float)));
+            GLState::enable_attribute(program->get_tex_coordinate_attribute());
+
+            glDrawArrays(GL_TRIANGLES, 0, chunk.vertex_count);
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "ShaderProgram.h"
+
+// tiles per chunk along each axis; one chunk is one VBO and one draw call
+const int CHUNK_COLUMNS = 32;
+const int CHUNK_ROWS    = 16;
+
+// tile index 0 is empty; index n draws atlas cell n - 1, counted left to right, top to bottom
+const unsigned char EMPTY_TILE = 0;
+
+struct TileChunk
+{
+    GLuint vertex_buffer = 0;
+    int    vertex_count  = 0;
+    bool   dirty         = true;
+};
+
+// A grid of tile indices drawn from one atlas texture. The grid is split into chunks whose
+// quads are baked into static VBOs; editing a tile only marks its chunk for rebuilding,
+// which happens on the next render, so an untouched level costs one draw per visible chunk.
+// Tiles are edited and rendered on the thread that owns the GL context.
+class TileMap
+{
+private:
+    std::vector<unsigned char> m_tiles;
+    std::vector<TileChunk>     m_chunks;
+    std::vector<float>         m_scratch;
+
+    int m_columns        = 0;
+    int m_rows           = 0;
+    int m_chunk_columns  = 0;
+    int m_chunk_rows     = 0;
+    int m_atlas_columns  = 1;
+    int m_atlas_rows     = 1;
+    unsigned int m_revision = 0;
+
+    // world position of the bottom-left corner of tile (0, 0)
+    glm::vec2 m_origin;
+    glm::vec2 m_tile_size;
+
+    void build_chunk(int chunk_x, int chunk_y);
+
+public:
+    GLuint texture_id;
+
+    // rows count upwards from origin
+    void create(int columns, int rows, glm::vec2 origin, glm::vec2 tile_size, int atlas_columns = 1, int atlas_rows = 1);
+    void destroy();
+
+    void set_tile(int column, int row, unsigned char tile);
+    unsigned char const get_tile(int column, int row) const;
+
+    // rebuilds edited chunks, then draws the chunks overlapping view_bounds (left, right, bottom, top)
+    void render(ShaderProgram* program, const glm::vec4& view_bounds);
+
+    int          const get_columns()  const { return m_columns;  };
+    int          const get_rows()     const { return m_rows;     };
+    unsigned int const get_revision() const { return m_revision; };
+};
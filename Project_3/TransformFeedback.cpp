@@ -0,0 +1,106 @@
+#define GL_SILENCE_DEPRECATION
+
+#include "TransformFeedback.h"
+#include <SDL.h>
+#include <cstdlib>
+
+TransformFeedbackApi TransformFeedback::s_api = TRANSFORM_FEEDBACK_NONE;
+
+TransformFeedbackApi TransformFeedback::detect()
+{
+#ifdef _WINDOWS
+    // GLEW leaves an entry point NULL unless the context really provides it
+    bool core = GLEW_VERSION_3_0 != 0;
+    bool ext  = GLEW_EXT_transform_feedback != 0;
+#else
+    const char *version = (const char *) glGetString(GL_VERSION);
+    bool core = version != NULL && atoi(version) >= 3;
+    bool ext  = SDL_GL_ExtensionSupported("GL_EXT_transform_feedback") != 0;
+#endif
+
+    // the headers decide which of the two we can even name
+    s_api = TRANSFORM_FEEDBACK_NONE;
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER
+    if (core) s_api = TRANSFORM_FEEDBACK_CORE;
+#endif
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER_EXT
+    if (s_api == TRANSFORM_FEEDBACK_NONE && ext) s_api = TRANSFORM_FEEDBACK_EXT;
+#endif
+    return s_api;
+}
+
+void TransformFeedback::set_varyings(GLuint program, int count, const char *const *varyings)
+{
+    switch (s_api) {
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER
+        case TRANSFORM_FEEDBACK_CORE:
+            glTransformFeedbackVaryings(program, count, varyings, GL_INTERLEAVED_ATTRIBS);
+            break;
+#endif
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER_EXT
+        case TRANSFORM_FEEDBACK_EXT:
+            glTransformFeedbackVaryingsEXT(program, count, varyings, GL_INTERLEAVED_ATTRIBS_EXT);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void TransformFeedback::bind_buffer(GLuint buffer)
+{
+    switch (s_api) {
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER
+        case TRANSFORM_FEEDBACK_CORE:
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, buffer);
+            break;
+#endif
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER_EXT
+        case TRANSFORM_FEEDBACK_EXT:
+            glBindBufferBaseEXT(GL_TRANSFORM_FEEDBACK_BUFFER_EXT, 0, buffer);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void TransformFeedback::begin_points()
+{
+    switch (s_api) {
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER
+        case TRANSFORM_FEEDBACK_CORE:
+            glEnable(GL_RASTERIZER_DISCARD);
+            glBeginTransformFeedback(GL_POINTS);
+            break;
+#endif
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER_EXT
+        case TRANSFORM_FEEDBACK_EXT:
+            glEnable(GL_RASTERIZER_DISCARD_EXT);
+            glBeginTransformFeedbackEXT(GL_POINTS);
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void TransformFeedback::end()
+{
+    switch (s_api) {
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER
+        case TRANSFORM_FEEDBACK_CORE:
+            glEndTransformFeedback();
+            glDisable(GL_RASTERIZER_DISCARD);
+            break;
+#endif
+#ifdef GL_TRANSFORM_FEEDBACK_BUFFER_EXT
+        case TRANSFORM_FEEDBACK_EXT:
+            glEndTransformFeedbackEXT();
+            glDisable(GL_RASTERIZER_DISCARD_EXT);
+            break;
+#endif
+        default:
+            break;
+    }
+}
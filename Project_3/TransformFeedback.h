@@ -0,0 +1,32 @@
+#pragma once
+
+#ifdef _WINDOWS
+    #include <GL/glew.h>
+#endif
+#define GL_GLEXT_PROTOTYPES 1
+#include <SDL_opengl.h>
+
+enum TransformFeedbackApi { TRANSFORM_FEEDBACK_NONE, TRANSFORM_FEEDBACK_CORE, TRANSFORM_FEEDBACK_EXT };
+
+// Transform feedback is core from GL 3.0; a 2.1 context (the legacy macOS one included) can only
+// offer it through GL_EXT_transform_feedback, whose entry points and enums carry an EXT suffix.
+// Everything here goes through whichever of the two detect() found, so nothing ever calls a
+// core entry point the context does not have.
+class TransformFeedback
+{
+private:
+    static TransformFeedbackApi s_api;
+
+public:
+    // call once the context is current
+    static TransformFeedbackApi detect();
+
+    static void set_varyings(GLuint program, int count, const char *const *varyings);
+    static void bind_buffer(GLuint buffer);
+
+    // captures GL_POINTS with rasterisation turned off until end()
+    static void begin_points();
+    static void end();
+
+    static TransformFeedbackApi const get_api() { return s_api; };
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+
+// Single-producer / single-consumer triple buffer.
+// The writer fills get_back() and publish()es it; the reader acquire()s the newest
+// published slot and reads get_front(). Neither side ever waits on the other:
+// a slot the reader has not picked up yet is simply overwritten by the next publish.
+template <typename T>
+class TripleBuffer
+{
+private:
+    enum { INDEX_MASK = 3, FRESH_BIT = 4 };
+    
+    T m_slots[3];
+    
+    // index of the slot in the middle, plus FRESH_BIT while it holds an unread publish
+    std::atomic<int> m_middle;
+    int m_back  = 0; // owned by the writer
+    int m_front = 2; // owned by the reader
+    
+public:
+    TripleBuffer() : m_middle(1) {}
+    
+    // ————— WRITER ————— //
+    T& get_back() { return m_slots[m_back]; }
+    
+    void publish()
+    {
+        int previous = m_middle.exchange(m_back | FRESH_BIT, std::memory_order_acq_rel);
+        m_back = previous & INDEX_MASK;
+    }
+    
+    // ————— READER ————— //
+    // returns false when nothing new has been published since the last acquire
+    bool acquire()
+    {
+        if ((m_middle.load(std::memory_order_acquire) & FRESH_BIT) == 0) return false;
+        
+        int previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+        return true;
+    }
+    
+    T& get_front() { return m_slots[m_front]; }
+};
@@ -10,6 +10,9 @@
 
 #define LOG(argument) std::cout << argument << '\n'
 #define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC(size) image_arena_malloc(size)
+#define STBI_REALLOC_SIZED(pointer, old_size, size) image_arena_realloc(pointer, old_size, size)
+#define STBI_FREE(pointer) image_arena_free(pointer)
 #define GL_SILENCE_DEPRECATION
 #define GL_GLEXT_PROTOTYPES 1
 #define FIXED_TIMESTEP 0.0166666f
@@ -26,11 +29,27 @@
 #include "glm/mat4x4.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "ShaderProgram.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+#include "RenderTarget.h"
+#include "FramePacer.h"
+#include "FrameCapture.h"
+#include "SoftwareRenderer.h"
+#include "FontBank.h"
+#include "DynamicResolution.h"
+#include "ParticleSystem.h"
+#include "TileMap.h"
+#include "AssetLoader.h"
+#include "ImageArena.h"
 #include "stb_image.h"
 #include "cmath"
 #include <ctime>
+#include <cstring>
 #include <vector>
+#include <atomic>
+#include <thread>
 #include "Entity.h"
+#include "TripleBuffer.h"
 
 // ————— STRUCTS AND ENUMS —————//
 struct GameState
@@ -39,6 +58,38 @@ struct GameState
     Entity* pillar;
     Entity* landing;
     Entity* result;
+    glm::vec3 thrust;
+};
+
+// what the render thread needs from one simulation step; entities are copied by value
+struct FrameSnapshot
+{
+    Entity player;
+    Entity pillar[NUM_PILLARS];
+    Entity landing[NUM_LANDINGS];
+    glm::vec3 thrust;
+    
+    // bumped whenever pillars or landings are (re)built
+    unsigned int terrain_revision;
+};
+
+// glyph quads for one (text, size, spacing) triple, kept in a VBO
+struct TextMesh
+{
+    std::string text;
+    float screen_size;
+    float spacing;
+    GLuint vertex_buffer;
+    int vertex_count;
+};
+
+// a DrawText call waiting in the render queue
+struct TextDraw
+{
+    std::string text;
+    float screen_size;
+    float spacing;
+    glm::vec3 position;
 };
 
 // ————— CONSTANTS ————— //
@@ -59,10 +110,12 @@ const char V_SHADER_PATH[] = "shaders/vertex_textured.glsl",
            F_SHADER_PATH[] = "shaders/fragment_textured.glsl";
 
 const float MILLISECONDS_IN_SECOND = 1000.0;
-const char  SPRITESHEET_FILEPATH[] = "/Users/allan_home/Documents/GitHub/Project-3-Lunar-Lander/Project_3/sprites/gundam.png",
-            PILLAR_FILEPATH[]  = "/Users/allan_home/Documents/GitHub/Project-3-Lunar-Lander/Project_3/sprites/flame pillar.png",
-            LANDING_FILEPATH[] = "/Users/allan_home/Documents/GitHub/Project-3-Lunar-Lander/Project_3/sprites/tile.png",
-            TEXT_FILEPATH[]    = "/Users/allan_home/Documents/GitHub/Project-3-Lunar-Lander/Project_3/sprites/font1.png";
+// relative to the working directory, like the shaders; also the names they have in the asset pack
+const char  SPRITESHEET_FILEPATH[] = "sprites/gundam.png",
+            PILLAR_FILEPATH[]  = "sprites/flame pillar.png",
+            LANDING_FILEPATH[] = "sprites/tile.png",
+            TEXT_FILEPATH[]    = "sprites/font1.png";
+const char  ASSET_PACK_FILEPATH[] = "assets.pack";
 
 const int NUMBER_OF_TEXTURES = 1;
 const GLint LEVEL_OF_DETAIL  = 0;
@@ -70,55 +123,169 @@ const GLint TEXTURE_BORDER   = 0;
 
 // ————— VARIABLES ————— //
 GameState game_state;
+unsigned int terrain_revision = 0;
+
+// sprites and shaders come from the pack when there is one, loose files otherwise
+AssetPack asset_pack;
+
+// textures are decoded together at startup; --serial-loading decodes them one by one for comparison
+AssetLoader asset_loader;
+bool parallel_loading = true;
+Uint64 startup_counter = 0;
+bool first_frame_reported = false;
 
 SDL_Window* display_window;
-bool game_is_running = true;
+SDL_GLContext gl_context;
+std::atomic<bool> game_is_running(true);
+
+// headless: hidden window, scene rendered into scene_target and captured to disk
+// (on machines without a display, run with SDL_VIDEODRIVER=offscreen)
+bool headless = false;
+unsigned int headless_frame_limit = 0;
+std::string capture_prefix = "capture_";
+RenderTarget scene_target;
+FrameCapture frame_capture;
+
+// windowed: when frames run long the scene is drawn smaller into scene_target and stretched to the window
+const float MIN_RESOLUTION_SCALE = 0.5f;
+DynamicResolution dynamic_resolution;
+bool scene_scaled = false;
+Entity scene_sprite;
+
+// thruster exhaust and crash debris, simulated on the GPU
+const int   PARTICLE_COUNT     = 32768;
+const float THRUSTER_EMIT_RATE = 20000.0f;
+const float MAX_PARTICLE_STEP  = 0.1f;
+ParticleSystem particles;
+Uint64 previous_particle_counter = 0;
+bool previous_landed_loss = false;
+
+// software: no GL at all; frames are rasterized on the CPU and written as <prefix>NNNNN.tga
+bool software = false;
+SoftwareRenderer software_renderer;
+std::vector<SoftwareTexture> software_textures;
+unsigned int software_frames_written = 0;
+
+// simulation (main thread) -> render thread
+TripleBuffer<FrameSnapshot> frame_snapshots;
+std::thread render_thread;
+std::atomic<bool> render_thread_running(false);
+
+// simulation ticks at the fixed timestep; rendering at the display rate, or on vsync when we get it
+const double DEFAULT_REFRESH_RATE = 60.0;
+FramePacer simulation_pacer;
+FramePacer render_pacer;
 
 ShaderProgram shader_program;
+RenderQueue render_queue;
+glm::vec4 view_bounds;
+
+// landing pads are drawn as tiles; the entities are kept for collisions
+const glm::vec2 TILEMAP_ORIGIN    = glm::vec2(-1.5f, -3.75f),
+                TILEMAP_TILE_SIZE = glm::vec2(1.0f, 0.5f);
+const unsigned char LANDING_TILE  = 1;
+TileMap terrain_tiles;
+
+// terrain never moves, so it is drawn once into static_layer and then shown as one quad
+RenderTarget static_layer;
+Entity static_layer_sprite;
+unsigned int static_layer_camera_revision  = 0;
+unsigned int static_layer_terrain_revision = 0;
+unsigned int static_layer_tile_revision    = 0;
 glm::mat4 view_matrix, projection_matrix;
 
 //text globals
 GLuint font_texture_id;
-const int FONTBANK_SIZE = 16;
+const int TEXT_CACHE_SIZE = 8;
+const GLsizei TEXT_VERTEX_STRIDE = 4 * sizeof(float);
+
+TextDraw win_message  = { "MISSION SUCCESS!", 0.5f, 0.01f, glm::vec3(-4.0f, 0.0f, 0.0f) },
+         loss_message = { "MISSION FAILED.",  0.5f, 0.01f, glm::vec3(-4.0f, 0.0f, 0.0f) };
+
+TextMesh text_cache[TEXT_CACHE_SIZE];
+int text_cache_count = 0;
+int text_cache_next = 0;
+std::vector<float> text_scratch;
 
 float previous_ticks = 0.0f;
 float time_accumulator = 0.0f;
 
 
 // ———— GENERAL FUNCTIONS ———— //
-GLuint load_texture(const char* filepath) {
-    int width, height, number_of_components;
-    unsigned char* image = stbi_load(filepath, &width, &height, &number_of_components, STBI_rgb_alpha);
-
-    if (image == NULL) {
-        LOG("Unable to load image. Make sure the path is correct.");
-        assert(false);
+GLuint upload_texture(LoadedImage& image) {
+    int width, height;
+    const unsigned char* pixels = image.get_level(0, &width, &height);
+
+    //in software mode a "texture id" indexes software_textures
+    if (software) {
+        software_textures.push_back(SoftwareTexture());
+        SoftwareTexture& texture = software_textures.back();
+        texture.width  = width;
+        texture.height = height;
+        texture.pixels.resize(width * height);
+        memcpy(texture.pixels.data(), pixels, width * height * 4);
+        return (GLuint) (software_textures.size() - 1);
     }
 
     GLuint textureID;
     glGenTextures(NUMBER_OF_TEXTURES, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, image);
+    GLState::bind_texture(textureID);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    //level 0 plus its mips; zoomed-out cameras sample a smaller level instead of striding across level 0
+    int level_count = image.get_level_count();
+    for (int level = 0; level < level_count; level++) {
+        pixels = image.get_level(level, &width, &height);
+        glTexImage2D(GL_TEXTURE_2D, LEVEL_OF_DETAIL + level, GL_RGBA, width, height, TEXTURE_BORDER, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, LEVEL_OF_DETAIL + level_count - 1);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-    stbi_image_free(image);
-
     return textureID;
 }
 
-void DrawText(ShaderProgram* program, GLuint font_texture_id, std::string text, float screen_size, float spacing, glm::vec3 position) {
+//decodes every requested image at once on the pool, then uploads them here, on the thread holding the context
+void load_textures(std::vector<GLuint>& texture_ids) {
+    unsigned int thread_count = parallel_loading ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    if (!asset_loader.decode(thread_count, !software)) {
+        LOG("Unable to load image. Make sure the path is correct.");
+        assert(false);
+    }
+    Uint64 decoded = SDL_GetPerformanceCounter();
+
+    texture_ids.clear();
+    for (int i = 0; i < asset_loader.get_image_count(); i++) texture_ids.push_back(upload_texture(asset_loader.get_image(i)));
+    asset_loader.release();
+    Uint64 uploaded = SDL_GetPerformanceCounter();
+
+    double frequency = (double) SDL_GetPerformanceFrequency();
+    LOG("Loaded " << texture_ids.size() << " textures on " << thread_count << " threads: decode "
+        << (decoded - start) * MILLISECONDS_IN_SECOND / frequency << " ms, upload "
+        << (uploaded - decoded) * MILLISECONDS_IN_SECOND / frequency << " ms");
+}
+
+void report_first_frame() {
+    if (first_frame_reported) return;
+    first_frame_reported = true;
+
+    double milliseconds = (SDL_GetPerformanceCounter() - startup_counter) * MILLISECONDS_IN_SECOND / SDL_GetPerformanceFrequency();
+    LOG("Time to first frame: " << milliseconds << " ms (" << (parallel_loading ? "parallel" : "serial") << " asset loading)");
+}
+
+void build_text_vertices(const std::string& text, float screen_size, float spacing, std::vector<float>& vertices) {
     
     float width = 1.0f / FONTBANK_SIZE;
     float height = 1.0f / FONTBANK_SIZE;
     
-    std::vector<float> vertices;
-    std::vector<float> texture_coordinates;
+    vertices.clear();
 
+    // interleaved x, y, u, v per vertex
     for (int i = 0; i < text.size(); i++) {
         int spritesheet_index = (int) text[i];
         float offset = (screen_size + spacing) * i;
@@ -127,51 +294,202 @@ void DrawText(ShaderProgram* program, GLuint font_texture_id, std::string text,
         float v_coordinate = (float) (spritesheet_index / FONTBANK_SIZE) / FONTBANK_SIZE;
 
         vertices.insert(vertices.end(), {
-            offset + (-0.5f * screen_size), 0.5f * screen_size,
-            offset + (-0.5f * screen_size), -0.5f * screen_size,
-            offset + (0.5f * screen_size), 0.5f * screen_size,
-            offset + (0.5f * screen_size), -0.5f * screen_size,
-            offset + (0.5f * screen_size), 0.5f * screen_size,
-            offset + (-0.5f * screen_size), -0.5f * screen_size,
+            offset + (-0.5f * screen_size), 0.5f * screen_size,  u_coordinate, v_coordinate,
+            offset + (-0.5f * screen_size), -0.5f * screen_size, u_coordinate, v_coordinate + height,
+            offset + (0.5f * screen_size), 0.5f * screen_size,   u_coordinate + width, v_coordinate,
+            offset + (0.5f * screen_size), -0.5f * screen_size,  u_coordinate + width, v_coordinate + height,
+            offset + (0.5f * screen_size), 0.5f * screen_size,   u_coordinate + width, v_coordinate,
+            offset + (-0.5f * screen_size), -0.5f * screen_size, u_coordinate, v_coordinate + height,
         });
+    }
+}
 
-        texture_coordinates.insert(texture_coordinates.end(), {
-            u_coordinate, v_coordinate,
-            u_coordinate, v_coordinate + height,
-            u_coordinate + width, v_coordinate,
-            u_coordinate + width, v_coordinate + height,
-            u_coordinate + width, v_coordinate,
-            u_coordinate, v_coordinate + height,
-        });
+TextMesh* get_text_mesh(const std::string& text, float screen_size, float spacing) {
+    for (int i = 0; i < text_cache_count; i++) {
+        TextMesh* mesh = &text_cache[i];
+        if (mesh->screen_size == screen_size && mesh->spacing == spacing && mesh->text == text) return mesh;
     }
 
+    // miss: take a free slot, or recycle the oldest one once the cache is full
+    TextMesh* mesh;
+    if (text_cache_count < TEXT_CACHE_SIZE) {
+        mesh = &text_cache[text_cache_count++];
+        glGenBuffers(1, &mesh->vertex_buffer);
+    }
+    else {
+        mesh = &text_cache[text_cache_next];
+        text_cache_next = (text_cache_next + 1) % TEXT_CACHE_SIZE;
+    }
+
+    mesh->text = text;
+    mesh->screen_size = screen_size;
+    mesh->spacing = spacing;
+    mesh->vertex_count = (int) (text.size() * 6);
+
+    build_text_vertices(text, screen_size, spacing, text_scratch);
+
+    GLState::bind_array_buffer(mesh->vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, text_scratch.size() * sizeof(float), text_scratch.data(), GL_STATIC_DRAW);
+
+    return mesh;
+}
+
+void DrawText(ShaderProgram* program, GLuint font_texture_id, const std::string& text, float screen_size, float spacing, glm::vec3 position) {
+    
+    TextMesh* mesh = get_text_mesh(text, screen_size, spacing);
+
     glm::mat4 model_matrix = glm::mat4(1.0f);
     model_matrix = glm::translate(model_matrix, position);
     
     program->set_model_matrix(model_matrix);
-    glUseProgram(program->get_program_id());
+    GLState::use_program(program->get_program_id());
+    
+    GLState::bind_array_buffer(mesh->vertex_buffer);
+    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, TEXT_VERTEX_STRIDE, (void*) 0);
+    GLState::enable_attribute(program->get_position_attribute());
+    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, TEXT_VERTEX_STRIDE, (void*) (2 * sizeof(float)));
+    GLState::enable_attribute(program->get_tex_coordinate_attribute());
     
-    glVertexAttribPointer(program->get_position_attribute(), 2, GL_FLOAT, false, 0, vertices.data());
-    glEnableVertexAttribArray(program->get_position_attribute());
-    glVertexAttribPointer(program->get_tex_coordinate_attribute(), 2, GL_FLOAT, false, 0, texture_coordinates.data());
-    glEnableVertexAttribArray(program->get_tex_coordinate_attribute());
+    GLState::bind_texture(font_texture_id);
+    glDrawArrays(GL_TRIANGLES, 0, mesh->vertex_count);
+}
+
+void draw_entity(ShaderProgram* program, void* data) {
+    ((Entity*) data)->render(program);
+}
+
+void draw_text(ShaderProgram* program, void* data) {
+    TextDraw* message = (TextDraw*) data;
+    DrawText(program, font_texture_id, message->text, message->screen_size, message->spacing, message->position);
+}
+
+// world-space (left, right, bottom, top) covered by the current camera
+glm::vec4 get_view_bounds() {
+    glm::mat4 inverse_view_projection = glm::inverse(ShaderProgram::get_view_projection_matrix());
+    glm::vec4 bottom_left = inverse_view_projection * glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f);
+    glm::vec4 top_right   = inverse_view_projection * glm::vec4( 1.0f,  1.0f, 0.0f, 1.0f);
+
+    return glm::vec4(glm::min(bottom_left.x, top_right.x), glm::max(bottom_left.x, top_right.x),
+                     glm::min(bottom_left.y, top_right.y), glm::max(bottom_left.y, top_right.y));
+}
+
+void submit_entity(RenderLayer layer, Entity* entity) {
+    //off-screen sprites never reach the queue
+    if (!entity->in_view(view_bounds)) return;
     
-    glBindTexture(GL_TEXTURE_2D, font_texture_id);
-    glDrawArrays(GL_TRIANGLES, 0, (int) (text.size() * 6));
+    render_queue.submit(layer, &shader_program, entity->texture_id, entity->get_position().z, draw_entity, entity);
+}
+
+void publish_snapshot() {
+    FrameSnapshot& frame = frame_snapshots.get_back();
+    frame.player = *game_state.player;
+    for (int i = 0; i < NUM_PILLARS; i++)  frame.pillar[i]  = game_state.pillar[i];
+    for (int i = 0; i < NUM_LANDINGS; i++) frame.landing[i] = game_state.landing[i];
+    frame.thrust = game_state.thrust;
+    frame.terrain_revision = terrain_revision;
+    frame_snapshots.publish();
+}
+
+// the window's framebuffer normally; the offscreen target when headless
+void bind_scene_target() {
+    if ((headless || scene_scaled) && scene_target.is_valid()) scene_target.bind();
+    else RenderTarget::bind_default(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+}
+
+void update_scene_scale() {
+    if (headless) return;
+
+    float scale = dynamic_resolution.get_scale();
+    scene_scaled = scale < 1.0f;
+    if (!scene_scaled) return;
+
+    int width  = (int) (VIEWPORT_WIDTH * scale);
+    int height = (int) (VIEWPORT_HEIGHT * scale);
+    if (!scene_target.is_valid() && !scene_target.create(width, height, GL_LINEAR)) {
+        scene_scaled = false;
+        return;
+    }
+    scene_target.resize(width, height);
+}
+
+//stretches the reduced-resolution scene over the whole window
+void present_scene() {
+    RenderTarget::bind_default(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+
+    //same flipped full-view quad as the static layer; the scene is opaque, so no blending
+    scene_sprite.texture_id = scene_target.get_texture_id();
+    scene_sprite.set_position(glm::vec3((view_bounds.x + view_bounds.y) / 2.0f, (view_bounds.z + view_bounds.w) / 2.0f, 0.0f));
+    scene_sprite.set_width(view_bounds.y - view_bounds.x);
+    scene_sprite.set_height(-(view_bounds.w - view_bounds.z));
+    scene_sprite.update(0.0f, NULL, 0);
+
+    GLState::set_blend(false);
+    scene_sprite.render(&shader_program);
+    GLState::set_blend(true);
+}
+
+void capture_frame() {
+    //render_loop has already stopped the game when the target could not be created
+    if (!scene_target.is_valid() || frame_capture.get_frames_captured() >= headless_frame_limit) return;
+
+    frame_capture.capture();
+    if (frame_capture.get_frames_captured() >= headless_frame_limit) game_is_running = false;
+}
+
+void draw_static_layer(ShaderProgram* program, void* data) {
+    //the layer texture holds premultiplied colour
+    GLState::set_blend_func(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    ((Entity*) data)->render(program);
+    GLState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void draw_tilemap(ShaderProgram* program, void* data) {
+    ((TileMap*) data)->render(program, view_bounds);
+}
+
+void submit_terrain(FrameSnapshot* frame) {
+    //pillar
+    for (int i = 0; i < NUM_PILLARS; i++) submit_entity(LAYER_TERRAIN, &frame->pillar[i]);
     
-    glDisableVertexAttribArray(program->get_position_attribute());
-    glDisableVertexAttribArray(program->get_tex_coordinate_attribute());
+    //landing
+    render_queue.submit(LAYER_TERRAIN, &shader_program, terrain_tiles.texture_id, 0.0f, draw_tilemap, &terrain_tiles);
 }
 
-void initialise() {
+void render_static_layer(FrameSnapshot* frame) {
+    static_layer.bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    //premultiply on the way in so the composite is exact for partially transparent texels
+    GLState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    submit_terrain(frame);
+    render_queue.flush();
+    GLState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    bind_scene_target();
+    glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
+
+    //one quad covering the view; negative height flips it, since framebuffer rows run bottom-up
+    static_layer_sprite.texture_id = static_layer.get_texture_id();
+    static_layer_sprite.set_position(glm::vec3((view_bounds.x + view_bounds.y) / 2.0f, (view_bounds.z + view_bounds.w) / 2.0f, 0.0f));
+    static_layer_sprite.set_width(view_bounds.y - view_bounds.x);
+    static_layer_sprite.set_height(-(view_bounds.w - view_bounds.z));
+    static_layer_sprite.update(0.0f, NULL, 0);
+
+    static_layer_camera_revision  = ShaderProgram::get_camera_revision();
+    static_layer_terrain_revision = frame->terrain_revision;
+    static_layer_tile_revision    = terrain_tiles.get_revision();
+}
+
+void initialise_display() {
     SDL_Init(SDL_INIT_VIDEO);
     display_window = SDL_CreateWindow("Lunar Lander A.V. edition",
         SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
         WINDOW_WIDTH, WINDOW_HEIGHT,
-        SDL_WINDOW_OPENGL);
+        SDL_WINDOW_OPENGL | (headless ? SDL_WINDOW_HIDDEN : 0));
 
-    SDL_GLContext context = SDL_GL_CreateContext(display_window);
-    SDL_GL_MakeCurrent(display_window, context);
+    gl_context = SDL_GL_CreateContext(display_window);
+    SDL_GL_MakeCurrent(display_window, gl_context);
 
 #ifdef _WINDOWS
     glewInit();
@@ -179,19 +497,57 @@ void initialise() {
 
     glViewport(VIEWPORT_X, VIEWPORT_Y, VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
 
-    shader_program.load(V_SHADER_PATH, F_SHADER_PATH);
+    //pacing
+    SDL_DisplayMode display_mode;
+    double refresh_rate = DEFAULT_REFRESH_RATE;
+    if (SDL_GetWindowDisplayMode(display_window, &display_mode) == 0 && display_mode.refresh_rate > 0) {
+        refresh_rate = display_mode.refresh_rate;
+    }
+    bool vsync = SDL_GL_SetSwapInterval(1) == 0 && SDL_GL_GetSwapInterval() == 1;
 
-    view_matrix       = glm::mat4(1.0f);
-    projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
+    render_pacer.start(refresh_rate);
+    render_pacer.set_vsync(vsync);
 
-    shader_program.set_projection_matrix(projection_matrix);
-    shader_program.set_view_matrix(view_matrix);
+    shader_program.load(V_SHADER_PATH, F_SHADER_PATH);
 
-    glUseProgram(shader_program.get_program_id());
+    GLState::use_program(shader_program.get_program_id());
 
     glClearColor(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
+
+    //window
+    GLState::set_blend(true);
+    GLState::set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void initialise() {
+    if (asset_pack.open(ASSET_PACK_FILEPATH)) {
+        ShaderProgram::set_asset_pack(&asset_pack);
+        asset_loader.set_pack(&asset_pack);
+    }
+    else LOG("No asset pack at " << ASSET_PACK_FILEPATH << ", loading loose files");
+
+    //the software renderer needs no window or GL context at all
+    if (software) SDL_Init(0);
+    else initialise_display();
+
+    simulation_pacer.start(1.0 / FIXED_TIMESTEP);
+
+    view_matrix       = glm::mat4(1.0f);
+    projection_matrix = glm::ortho(-5.0f, 5.0f, -3.75f, 3.75f, -1.0f, 1.0f);
+
+    ShaderProgram::set_projection_matrix(projection_matrix);
+    ShaderProgram::set_view_matrix(view_matrix);
     
-    font_texture_id = load_texture(TEXT_FILEPATH);
+    int font_image    = asset_loader.request(TEXT_FILEPATH),
+        player_image  = asset_loader.request(SPRITESHEET_FILEPATH),
+        pillar_image  = asset_loader.request(PILLAR_FILEPATH),
+        landing_image = asset_loader.request(LANDING_FILEPATH);
+
+    //every pillar and landing pad shares one texture
+    std::vector<GLuint> texture_ids;
+    load_textures(texture_ids);
+    
+    font_texture_id = texture_ids[font_image];
 
     //player
     game_state.player = new Entity();
@@ -202,7 +558,7 @@ void initialise() {
     game_state.player->set_movement(glm::vec3(0.0f));
     game_state.player->set_acceleration(glm::vec3(0.0f, ACC_OF_GRAVITY * 0.05f, 0.0f));
     game_state.player->set_speed(1.0f);
-    game_state.player->texture_id = load_texture(SPRITESHEET_FILEPATH);
+    game_state.player->texture_id = texture_ids[player_image];
 
     //pillar
     game_state.pillar = new Entity[NUM_PILLARS];
@@ -211,7 +567,7 @@ void initialise() {
         game_state.pillar[i].set_height(2.0f);
         game_state.pillar[i].set_width(0.5f);
         game_state.pillar[i].e_type = PILLAR;
-        game_state.pillar[i].texture_id = load_texture(PILLAR_FILEPATH);
+        game_state.pillar[i].texture_id = texture_ids[pillar_image];
         game_state.pillar[i].set_position(glm::vec3((2.0f * i) - 4.0f, -3.0f + i, 0.0f));
         game_state.pillar[i].update(0.0f, NULL, 0);
     }
@@ -223,14 +579,24 @@ void initialise() {
     for (int i = 0; i < NUM_LANDINGS; i++) {
         game_state.landing[i].set_height(0.5f);
         game_state.landing[i].e_type = LANDING;
-        game_state.landing[i].texture_id = load_texture(LANDING_FILEPATH);
+        game_state.landing[i].texture_id = texture_ids[landing_image];
         game_state.landing[i].set_position(glm::vec3((2.0f * i) - 1.0f, -3.5f, 0.0f));
         game_state.landing[i].update(0.0f, NULL, 0);
     }
+    
+    //the tilemap is only read by the render thread, which starts after this
+    terrain_tiles.create(2 * NUM_LANDINGS, 1, TILEMAP_ORIGIN, TILEMAP_TILE_SIZE);
+    terrain_tiles.texture_id = game_state.landing[0].texture_id;
+    for (int i = 0; i < NUM_LANDINGS; i++) {
+        glm::vec3 position = game_state.landing[i].get_position();
+        terrain_tiles.set_tile((int) ((position.x - TILEMAP_ORIGIN.x) / TILEMAP_TILE_SIZE.x),
+                               (int) ((position.y - TILEMAP_ORIGIN.y) / TILEMAP_TILE_SIZE.y), LANDING_TILE);
+    }
 
-    //window
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    terrain_revision++;
+
+    //first frame, so the render thread has something to draw
+    publish_snapshot();
 }
 
 void process_input() {
@@ -261,6 +627,7 @@ void process_input() {
     }
     
     const Uint8* key_state = SDL_GetKeyboardState(NULL);
+    game_state.thrust = glm::vec3(0.0f);
     if (game_state.player->get_active() == true) {
         if (key_state[SDL_SCANCODE_LEFT]) {
             game_state.player->set_acceleration(glm::vec3(-0.15, 0.0f, 0.0f));
@@ -278,6 +645,12 @@ void process_input() {
             game_state.player->set_acceleration(glm::vec3(0.0f, ACC_OF_GRAVITY * 0.01f, 0.0f));
         }
         
+        //any key other than free fall fires a thruster
+        if (key_state[SDL_SCANCODE_LEFT] || key_state[SDL_SCANCODE_RIGHT] ||
+            key_state[SDL_SCANCODE_DOWN] || key_state[SDL_SCANCODE_UP]) {
+            game_state.thrust = glm::normalize(game_state.player->get_acceleration());
+        }
+        
         //normalize speed
         if (glm::length(game_state.player->get_movement()) > 1.0f) {
             game_state.player->set_movement(glm::normalize(game_state.player->get_movement()));
@@ -307,48 +680,240 @@ void update() {
     }
     time_accumulator = delta_time;
 
-    
-    
+    publish_snapshot();
+}
+
+void draw_particles(ShaderProgram* program, void* data) {
+    ((ParticleSystem*) data)->render();
 }
 
-void render() {
+void update_particles(FrameSnapshot* frame) {
+    Uint64 counter = SDL_GetPerformanceCounter();
+    float delta_time = previous_particle_counter == 0 ? 0.0f : (float) (counter - previous_particle_counter) / SDL_GetPerformanceFrequency();
+    previous_particle_counter = counter;
+    if (delta_time > MAX_PARTICLE_STEP) delta_time = MAX_PARTICLE_STEP;
+
+    //exhaust leaves opposite the thrust; a crash blows every particle out at once
+    bool thrusting = frame->thrust != glm::vec3(0.0f);
+    bool crashed = frame->player.landed_loss && !previous_landed_loss;
+    previous_landed_loss = frame->player.landed_loss;
+
+    glm::vec3 position = frame->player.get_position();
+    particles.update(delta_time, glm::vec2(position), -glm::vec2(frame->thrust), thrusting ? THRUSTER_EMIT_RATE : 0.0f, crashed);
+}
+
+void render(FrameSnapshot* frame) {
+    view_bounds = get_view_bounds();
+    update_scene_scale();
+
+    //terrain, re-baked only when the level or the camera changes
+    bool static_layer_stale = static_layer_camera_revision != ShaderProgram::get_camera_revision() ||
+                              static_layer_terrain_revision != frame->terrain_revision ||
+                              static_layer_tile_revision != terrain_tiles.get_revision();
+    if (static_layer.is_valid() && static_layer_stale) render_static_layer(frame);
+
     //window
+    bind_scene_target();
     glClear(GL_COLOR_BUFFER_BIT);
 
     //player
-    game_state.player->render(&shader_program);
+    submit_entity(LAYER_ACTORS, &frame->player);
 
-    //pillar
-    for (int i = 0; i < NUM_PILLARS; i++) game_state.pillar[i].render(&shader_program);
-    
-    //landing
-    for (int i = 0; i < NUM_LANDINGS; i++) game_state.landing[i].render(&shader_program);
+    //particles
+    if (particles.get_supported()) {
+        update_particles(frame);
+        render_queue.submit(LAYER_EFFECTS, particles.get_draw_program(), 0, 0.0f, draw_particles, &particles);
+    }
+
+    //terrain
+    if (static_layer.is_valid()) {
+        render_queue.submit(LAYER_TERRAIN, &shader_program, static_layer.get_texture_id(), 0.0f, draw_static_layer, &static_layer_sprite);
+    }
+    else submit_terrain(frame);
     
-    if (game_state.player->landed_win) {
-        DrawText(&shader_program, font_texture_id, "MISSION SUCCESS!", 0.5f, 0.01f, glm::vec3(-4.0f, 0.0f, 0.0f));
+    if (frame->player.landed_win) {
+        render_queue.submit(LAYER_HUD, &shader_program, font_texture_id, win_message.position.z, draw_text, &win_message);
     }
-    else if (game_state.player->landed_loss){
-        DrawText(&shader_program, font_texture_id, "MISSION FAILED.", 0.5f, 0.01f, glm::vec3(-4.0f, 0.0f, 0.0f));
+    else if (frame->player.landed_loss){
+        render_queue.submit(LAYER_HUD, &shader_program, font_texture_id, loss_message.position.z, draw_text, &loss_message);
     }
+    
+    //sorted by layer, then program and texture
+    render_queue.flush();
 
     //window
-    SDL_GL_SwapWindow(display_window);
+    if (headless) capture_frame();
+    else {
+        if (scene_scaled) present_scene();
+        SDL_GL_SwapWindow(display_window);
+    }
+    report_first_frame();
 }
 
-void shutdown() { SDL_Quit(); }
+void render_software(FrameSnapshot* frame) {
+    software_renderer.set_view_projection(ShaderProgram::get_view_projection_matrix());
+    software_renderer.clear(BG_RED, BG_BLUE, BG_GREEN, BG_OPACITY);
+    view_bounds = get_view_bounds();
+
+    //same layer order as the GL path: terrain, player, HUD
+    for (int i = 0; i < NUM_PILLARS; i++) {
+        if (frame->pillar[i].in_view(view_bounds)) software_renderer.draw_sprite(frame->pillar[i].get_model_matrix(), &software_textures[frame->pillar[i].texture_id]);
+    }
+    for (int i = 0; i < NUM_LANDINGS; i++) {
+        if (frame->landing[i].in_view(view_bounds)) software_renderer.draw_sprite(frame->landing[i].get_model_matrix(), &software_textures[frame->landing[i].texture_id]);
+    }
+    if (frame->player.in_view(view_bounds)) software_renderer.draw_sprite(frame->player.get_model_matrix(), &software_textures[frame->player.texture_id]);
+
+    TextDraw* message = frame->player.landed_win ? &win_message : frame->player.landed_loss ? &loss_message : NULL;
+    if (message != NULL) {
+        software_renderer.draw_text(&software_textures[font_texture_id], message->text, message->screen_size, message->spacing, message->position);
+    }
+
+    software_renderer.flush();
+
+    char filename[512];
+    snprintf(filename, sizeof(filename), "%s%05u.tga", capture_prefix.c_str(), software_frames_written);
+    software_renderer.write_tga(filename);
+    report_first_frame();
+    if (++software_frames_written >= headless_frame_limit) game_is_running = false;
+}
+
+void software_render_loop() {
+    software_renderer.create(VIEWPORT_WIDTH, VIEWPORT_HEIGHT, (int) std::max(1u, std::thread::hardware_concurrency()));
+
+    while (render_thread_running.load(std::memory_order_acquire)) {
+        if (software_frames_written >= headless_frame_limit || !frame_snapshots.acquire()) {
+            std::this_thread::yield();
+            continue;
+        }
+        render_software(&frame_snapshots.get_front());
+    }
+
+    software_renderer.destroy();
+    LOG("Rendered " << software_frames_written << " frames in software");
+}
+
+// ———— RENDER THREAD ———— //
+// Owns the GL context once the game loop starts; everything GL after initialise() happens here.
+void render_loop() {
+    SDL_GL_MakeCurrent(display_window, gl_context);
+
+    static_layer.create(VIEWPORT_WIDTH, VIEWPORT_HEIGHT);
+    dynamic_resolution.start(render_pacer.get_target_seconds(), MIN_RESOLUTION_SCALE, 1.0f);
+    if (!particles.create(PARTICLE_COUNT)) LOG("No transform feedback or the particle shaders failed to link, particles are disabled");
+    if (headless) {
+        //nothing could ever be captured, so an unattended run would never finish
+        if (scene_target.create(VIEWPORT_WIDTH, VIEWPORT_HEIGHT)) frame_capture.start(VIEWPORT_WIDTH, VIEWPORT_HEIGHT, capture_prefix);
+        else {
+            LOG("Unable to create the headless render target, stopping.");
+            game_is_running = false;
+        }
+    }
+
+    while (render_thread_running.load(std::memory_order_acquire)) {
+        //keeps the previous snapshot if the simulation has not published a new one,
+        //except when capturing, where every captured frame should be a distinct step
+        bool fresh = frame_snapshots.acquire();
+        if (headless && !fresh) {
+            std::this_thread::yield();
+            continue;
+        }
+        Uint64 frame_start = SDL_GetPerformanceCounter();
+        render(&frame_snapshots.get_front());
+        dynamic_resolution.frame_finished((double) (SDL_GetPerformanceCounter() - frame_start) / SDL_GetPerformanceFrequency());
+
+        //no-op under vsync, where the swap itself blocks
+        if (!headless) render_pacer.wait();
+    }
+
+    LOG("GL calls issued: " << GLState::get_calls_issued() << ", skipped: " << GLState::get_calls_skipped());
+    for (int i = 0; i < text_cache_count; i++) glDeleteBuffers(1, &text_cache[i].vertex_buffer);
+    static_layer.destroy();
+    particles.destroy();
+    terrain_tiles.destroy();
+    if (headless) {
+        frame_capture.stop();
+        LOG("Captured " << frame_capture.get_frames_captured() << " frames");
+    }
+    scene_target.destroy();
+
+    SDL_GL_MakeCurrent(display_window, NULL);
+}
+
+void start_render_thread() {
+    render_thread_running.store(true, std::memory_order_release);
+    if (software) {
+        render_thread = std::thread(software_render_loop);
+        return;
+    }
+
+    //hand the context over; a context can only be current on one thread
+    SDL_GL_MakeCurrent(display_window, NULL);
+    render_thread = std::thread(render_loop);
+}
+
+void stop_render_thread() {
+    render_thread_running.store(false, std::memory_order_release);
+    render_thread.join();
+}
+
+void shutdown() {
+    if (!software) SDL_GL_DeleteContext(gl_context);
+    asset_pack.close();
+    SDL_Quit();
+}
+
+//a run that stops after zero frames would never stop at all
+bool parse_frame_count(const char* text, unsigned int* frames) {
+    int count = atoi(text);
+    if (count <= 0) {
+        LOG("Expected a positive frame count, got \"" << text << "\"");
+        return false;
+    }
+    *frames = (unsigned int) count;
+    return true;
+}
+
+// --headless <frames> | --software <frames>, optionally --capture-prefix <path prefix>
+bool parse_arguments(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--headless" && i + 1 < argc) {
+            headless = true;
+            if (!parse_frame_count(argv[++i], &headless_frame_limit)) return false;
+        }
+        else if (argument == "--software" && i + 1 < argc) {
+            software = true;
+            if (!parse_frame_count(argv[++i], &headless_frame_limit)) return false;
+        }
+        else if (argument == "--capture-prefix" && i + 1 < argc) {
+            capture_prefix = argv[++i];
+        }
+        else if (argument == "--serial-loading") {
+            parallel_loading = false;
+        }
+    }
+    return true;
+}
 
 //game
 int main(int argc, char* argv[])
 {
+    startup_counter = SDL_GetPerformanceCounter();
+    if (!parse_arguments(argc, argv)) return 1;
     initialise();
+    start_render_thread();
 
     while (game_is_running)
     {
         process_input();
         update();
-        render();
+
+        //input is polled right before each step, so pacing adds no latency to it
+        simulation_pacer.wait();
     }
 
+    stop_render_thread();
     shutdown();
     return 0;
 }
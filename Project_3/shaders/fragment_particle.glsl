@@ -0,0 +1,6 @@
+uniform vec4 color;
+varying float fade;
+
+void main() {
+    gl_FragColor = vec4(color.rgb, color.a * fade);
+}
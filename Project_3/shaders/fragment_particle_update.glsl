@@ -0,0 +1,4 @@
+
+void main() {
+    gl_FragColor = vec4(0.0);
+}
@@ -0,0 +1,15 @@
+attribute vec2 position;
+attribute vec2 life;
+
+uniform mat4 modelMatrix;
+uniform mat4 viewProjectionMatrix;
+
+varying float fade;
+
+void main()
+{
+    // dead particles are parked outside the clip volume
+    bool alive = life.x < life.y;
+    fade = alive ? 1.0 - life.x / life.y : 0.0;
+	gl_Position = alive ? viewProjectionMatrix * (modelMatrix * vec4(position, 0.0, 1.0)) : vec4(2.0, 2.0, 2.0, 1.0);
+}
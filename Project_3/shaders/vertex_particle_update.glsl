@@ -0,0 +1,57 @@
+attribute vec2 position;
+attribute vec2 velocity;
+attribute vec2 life;
+attribute float seed;
+
+uniform float deltaTime;
+uniform float time;
+uniform vec2 gravity;
+uniform vec2 emitterPosition;
+uniform vec2 emitterDirection;
+uniform float emitChance;
+uniform float burst;
+
+varying vec2 outPosition;
+varying vec2 outVelocity;
+varying vec2 outLife;
+varying float outSeed;
+
+float random(float salt)
+{
+    return fract(sin(seed * 12.9898 + time * 78.233 + salt) * 43758.5453);
+}
+
+void main()
+{
+    vec2 p = position;
+    vec2 v = velocity;
+    vec2 l = life;
+    l.x += deltaTime;
+    
+    if (burst > 0.5) {
+        float angle = random(1.0) * 6.2831853;
+        float speed = 0.5 + random(2.0) * 2.5;
+        p = emitterPosition;
+        v = vec2(cos(angle), sin(angle)) * speed;
+        l = vec2(0.0, 0.8 + random(3.0) * 1.2);
+    }
+    else if (l.x >= l.y) {
+        if (random(4.0) < emitChance) {
+            float angle = atan(emitterDirection.y, emitterDirection.x) + (random(1.0) - 0.5) * 0.6;
+            float speed = 1.0 + random(2.0) * 1.5;
+            p = emitterPosition;
+            v = vec2(cos(angle), sin(angle)) * speed;
+            l = vec2(0.0, 0.3 + random(3.0) * 0.4);
+        }
+    }
+    else {
+        v += gravity * deltaTime;
+        p += v * deltaTime;
+    }
+    
+    outPosition = p;
+    outVelocity = v;
+    outLife = l;
+    outSeed = seed;
+    gl_Position = vec4(p, 0.0, 1.0);
+}
@@ -2,14 +2,12 @@ attribute vec4 position;
 attribute vec2 texCoord;
 
 uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 projectionMatrix;
+uniform mat4 viewProjectionMatrix;
 
 varying vec2 texCoordVar;
 
 void main()
 {
-	vec4 p = viewMatrix * modelMatrix  * position;
     texCoordVar = texCoord;
-	gl_Position = projectionMatrix * p;
-}
\ No newline at end of file
+	gl_Position = viewProjectionMatrix * (modelMatrix * position);
+}
@@ -332,6 +332,10 @@ publish, and distribute this file as you see fit.
 // STBI_JPEG_OLD, but this will disable some of the SIMD decoding path
 // and hence cost some performance.
 //
+// PNG unfiltering of 8-bit RGB and RGBA rows also has SSE2 kernels, plus SSSE3
+// and AVX2 ones where the compiler can target them per function (GCC 4.9+,
+// Clang, MSVC 2010+); the widest the CPU supports is picked at run time.
+//
 // If for some reason you do not want to use any of SIMD code, or if
 // you have issues compiling it, you can disable it entirely by
 // defining STBI_NO_SIMD.
@@ -442,6 +446,21 @@ STBIDEF stbi_uc *stbi_load_from_file  (FILE *f,                  int *x, int *y,
 // for stbi_load_from_file, file pointer is left pointing immediately after image
 #endif
 
+// as stbi_load_from_memory, but also hands each row of the result to a callback, e.g. to
+// start uploading a texture before the rest has decoded. y counts from the top of the
+// returned image and comp is req_comp, or *comp if that is 0; pixels are only valid
+// during the call. 8-bit, non-interlaced grey/RGB(A) PNGs without tRNS report each row
+// as it is inflated, unless req_comp needs a conversion; everything else reports all
+// the rows once the image is done.
+typedef void stbi_row_callback(void *user, int y, const stbi_uc *pixels, int width, int comp);
+STBIDEF stbi_uc *stbi_load_from_memory_rows(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, stbi_row_callback *row, void *user);
+
+// as stbi_load_from_memory, but decodes into out (e.g. a mapped pixel buffer object), which
+// must hold x * y * comp bytes with comp as above; returns 0 on failure, including when out
+// is too small. the PNGs that stream (see above) are written straight into out, others are
+// decoded as usual and copied. temporaries still go through STBI_MALLOC/STBI_FREE.
+STBIDEF int stbi_load_from_memory_into(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, stbi_uc *out, size_t out_size);
+
 #ifndef STBI_NO_LINEAR
    STBIDEF float *stbi_loadf                 (char const *filename,           int *x, int *y, int *comp, int req_comp);
    STBIDEF float *stbi_loadf_from_memory     (stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp);
@@ -502,6 +521,29 @@ STBIDEF void stbi_convert_iphone_png_to_rgb(int flag_true_if_should_convert);
 // flip the image vertically, so the first pixel in the output array is the bottom left
 STBIDEF void stbi_set_flip_vertically_on_load(int flag_true_if_should_flip);
 
+// as above, but only applies to images loaded on the thread that calls the function;
+// overrides the global setting for that thread. only available if the compiler
+// supports thread-local variables (see STBI_THREAD_LOCAL)
+STBIDEF void stbi_set_unpremultiply_on_load_thread(int flag_true_if_should_unpremultiply);
+STBIDEF void stbi_convert_iphone_png_to_rgb_thread(int flag_true_if_should_convert);
+STBIDEF void stbi_set_flip_vertically_on_load_thread(int flag_true_if_should_flip);
+
+// caps the x86 PNG unfiltering kernels, e.g. to compare them in a benchmark.
+// by default the widest the CPU supports is used; STBI_PNG_SIMD_NONE forces the
+// plain C loops. (not available when compiled with STBI_NO_SIMD or for non-x86)
+enum
+{
+   STBI_PNG_SIMD_NONE,
+   STBI_PNG_SIMD_SSE2,
+   STBI_PNG_SIMD_SSSE3,
+   STBI_PNG_SIMD_AVX2
+};
+STBIDEF void stbi_set_png_simd_limit(int level);
+
+// the same for the JPEG IDCT, YCbCr conversion and 2x2 upsampling, which have SSE2 and
+// AVX2 versions (SSSE3 means SSE2 here). every level produces identical pixels
+STBIDEF void stbi_set_jpeg_simd_limit(int level);
+
 // ZLIB client - used by PNG, available for other purposes
 
 STBIDEF char *stbi_zlib_decode_malloc_guesssize(const char *buffer, int len, int initial_size, int *outlen);
@@ -597,12 +639,14 @@ typedef unsigned short stbi__uint16;
 typedef   signed short stbi__int16;
 typedef unsigned int   stbi__uint32;
 typedef   signed int   stbi__int32;
+typedef unsigned __int64 stbi__uint64;
 #else
 #include <stdint.h>
 typedef uint16_t stbi__uint16;
 typedef int16_t  stbi__int16;
 typedef uint32_t stbi__uint32;
 typedef int32_t  stbi__int32;
+typedef uint64_t stbi__uint64;
 #endif
 
 // should produce compiler error if size is wrong
@@ -724,6 +768,46 @@ static int stbi__sse2_available()
 #endif
 #endif
 
+#ifdef STBI_SSE2
+// kernels beyond SSE2 are compiled per function (no global -m flags needed) and picked at
+// run time from the widest level the CPU supports, one of STBI_PNG_SIMD_*
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ * 100 + __GNUC_MINOR__) >= 409) || (defined(_MSC_VER) && _MSC_VER >= 1600)
+#define STBI__SIMD_EXT
+#include <tmmintrin.h>
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define STBI__TARGET(x)  __attribute__((target(x)))
+#else
+#define STBI__TARGET(x)
+#endif
+#endif
+
+static int stbi__x86_simd_level(void)
+{
+   int level = STBI_PNG_SIMD_NONE;
+   if (!stbi__sse2_available()) return level;
+   level = STBI_PNG_SIMD_SSE2;
+#ifdef STBI__SIMD_EXT
+#ifdef _MSC_VER
+   {
+      int info[4];
+      __cpuid(info, 1);
+      if (info[2] & (1 << 9)) level = STBI_PNG_SIMD_SSSE3;
+      // AVX2 also needs the OS to save the YMM registers: OSXSAVE, then XCR0 bits 1 and 2
+      if (level == STBI_PNG_SIMD_SSSE3 && (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6) {
+         __cpuidex(info, 7, 0);
+         if (info[1] & (1 << 5)) level = STBI_PNG_SIMD_AVX2;
+      }
+   }
+#else
+   if (__builtin_cpu_supports("ssse3")) level = STBI_PNG_SIMD_SSSE3;
+   if (level == STBI_PNG_SIMD_SSSE3 && __builtin_cpu_supports("avx2")) level = STBI_PNG_SIMD_AVX2;
+#endif
+#endif
+   return level;
+}
+#endif
+
 // ARM NEON
 #if defined(STBI_NO_SIMD) && defined(STBI_NEON)
 #undef STBI_NEON
@@ -759,6 +843,13 @@ typedef struct
 
    stbi_uc *img_buffer, *img_buffer_end;
    stbi_uc *img_buffer_original, *img_buffer_original_end;
+
+   stbi_row_callback *row_callback; // see stbi_load_from_memory_rows
+   void *row_user_data;
+   int rows_delivered;              // set by loaders that called row_callback themselves
+
+   stbi_uc *out_buffer;             // see stbi_load_from_memory_into; loaders may decode into it
+   size_t out_buffer_size;
 } stbi__context;
 
 
@@ -771,6 +862,10 @@ static void stbi__start_mem(stbi__context *s, stbi_uc const *buffer, int len)
    s->read_from_callbacks = 0;
    s->img_buffer = s->img_buffer_original = (stbi_uc *) buffer;
    s->img_buffer_end = s->img_buffer_original_end = (stbi_uc *) buffer+len;
+   s->row_callback = NULL;
+   s->rows_delivered = 0;
+   s->out_buffer = NULL;
+   s->out_buffer_size = 0;
 }
 
 // initialize a callback-based context
@@ -783,6 +878,10 @@ static void stbi__start_callbacks(stbi__context *s, stbi_io_callbacks *c, void *
    s->img_buffer_original = s->buffer_start;
    stbi__refill_buffer(s);
    s->img_buffer_original_end = s->img_buffer_end;
+   s->row_callback = NULL;
+   s->rows_delivered = 0;
+   s->out_buffer = NULL;
+   s->out_buffer_size = 0;
 }
 
 #ifndef STBI_NO_STDIO
@@ -881,8 +980,29 @@ static stbi_uc *stbi__pnm_load(stbi__context *s, int *x, int *y, int *comp, int
 static int      stbi__pnm_info(stbi__context *s, int *x, int *y, int *comp);
 #endif
 
-// this is not threadsafe
-static const char *stbi__g_failure_reason;
+// thread-local storage, so decodes running on several threads keep their
+// settings and failure reasons apart. #define STBI_THREAD_LOCAL yourself to
+// override; without it the state below is shared and not threadsafe
+#ifndef STBI_THREAD_LOCAL
+   #if defined(__cplusplus) && __cplusplus >= 201103L
+      #define STBI_THREAD_LOCAL       thread_local
+   #elif defined(__GNUC__) && __GNUC__ < 5
+      #define STBI_THREAD_LOCAL       __thread
+   #elif defined(_MSC_VER)
+      #define STBI_THREAD_LOCAL       __declspec(thread)
+   #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_THREADS__)
+      #define STBI_THREAD_LOCAL       _Thread_local
+   #elif defined(__GNUC__)
+      #define STBI_THREAD_LOCAL       __thread
+   #endif
+#endif
+
+#ifdef STBI_THREAD_LOCAL
+static STBI_THREAD_LOCAL
+#else
+static
+#endif
+const char *stbi__g_failure_reason;
 
 STBIDEF const char *stbi_failure_reason(void)
 {
@@ -928,13 +1048,29 @@ static float   *stbi__ldr_to_hdr(stbi_uc *data, int x, int y, int comp);
 static stbi_uc *stbi__hdr_to_ldr(float   *data, int x, int y, int comp);
 #endif
 
-static int stbi__vertically_flip_on_load = 0;
+static int stbi__vertically_flip_on_load_global = 0;
 
 STBIDEF void stbi_set_flip_vertically_on_load(int flag_true_if_should_flip)
 {
-    stbi__vertically_flip_on_load = flag_true_if_should_flip;
+    stbi__vertically_flip_on_load_global = flag_true_if_should_flip;
+}
+
+#ifndef STBI_THREAD_LOCAL
+#define stbi__vertically_flip_on_load  stbi__vertically_flip_on_load_global
+#else
+static STBI_THREAD_LOCAL int stbi__vertically_flip_on_load_local, stbi__vertically_flip_on_load_set;
+
+STBIDEF void stbi_set_flip_vertically_on_load_thread(int flag_true_if_should_flip)
+{
+    stbi__vertically_flip_on_load_local = flag_true_if_should_flip;
+    stbi__vertically_flip_on_load_set = 1;
 }
 
+#define stbi__vertically_flip_on_load  (stbi__vertically_flip_on_load_set       \
+                                         ? stbi__vertically_flip_on_load_local  \
+                                         : stbi__vertically_flip_on_load_global)
+#endif // STBI_THREAD_LOCAL
+
 static unsigned char *stbi__load_main(stbi__context *s, int *x, int *y, int *comp, int req_comp)
 {
    #ifndef STBI_NO_JPEG
@@ -1076,6 +1212,43 @@ STBIDEF stbi_uc *stbi_load_from_callbacks(stbi_io_callbacks const *clbk, void *u
    return stbi__load_flip(&s,x,y,comp,req_comp);
 }
 
+STBIDEF stbi_uc *stbi_load_from_memory_rows(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, stbi_row_callback *row, void *user)
+{
+   stbi__context s;
+   unsigned char *result;
+   stbi__start_mem(&s,buffer,len);
+   s.row_callback = row;
+   s.row_user_data = user;
+   result = stbi__load_flip(&s,x,y,comp,req_comp);
+   if (result && !s.rows_delivered) {
+      int j, n = req_comp ? req_comp : *comp;
+      for (j=0; j < *y; ++j)
+         row(user, j, result + (size_t) j * *x * n, *x, n);
+   }
+   return result;
+}
+
+STBIDEF int stbi_load_from_memory_into(stbi_uc const *buffer, int len, int *x, int *y, int *comp, int req_comp, stbi_uc *out, size_t out_size)
+{
+   stbi__context s;
+   unsigned char *result;
+   stbi__start_mem(&s,buffer,len);
+   s.out_buffer = out;
+   s.out_buffer_size = out_size;
+   result = stbi__load_flip(&s,x,y,comp,req_comp);
+   if (result == NULL) return 0;
+   if (result != out) {
+      size_t size = (size_t) *x * *y * (req_comp ? req_comp : *comp);
+      if (size > out_size) {
+         STBI_FREE(result);
+         return stbi__err("buffer too small", "Output buffer too small for the image");
+      }
+      memcpy(out, result, size);
+      STBI_FREE(result);
+   }
+   return 1;
+}
+
 #ifndef STBI_NO_LINEAR
 static float *stbi__loadf_main(stbi__context *s, int *x, int *y, int *comp, int req_comp)
 {
@@ -2204,6 +2377,180 @@ static void stbi__idct_simd(stbi_uc *out, int out_stride, short data[64])
 #undef dct_pass
 }
 
+#ifdef STBI__SIMD_EXT
+// avx2 integer IDCT: the arithmetic of stbi__idct_simd step for step, so also bit-identical,
+// but each pair of 32-bit halves (the _l/_h values there) is one 256-bit register. the
+// transposes stay 128-bit.
+static STBI__TARGET("avx2") void stbi__idct_avx2(stbi_uc *out, int out_stride, short data[64])
+{
+   __m128i row0, row1, row2, row3, row4, row5, row6, row7;
+   __m128i tmp;
+
+   // dot product constant: even elems=x, odd elems=y
+   #define dct_const(x,y)  _mm256_setr_epi16((x),(y),(x),(y),(x),(y),(x),(y),(x),(y),(x),(y),(x),(y),(x),(y))
+
+   // out(0) = c0[even]*x + c0[odd]*y   (c0, x, y 16-bit, out 32-bit)
+   // out(1) = c1[even]*x + c1[odd]*y
+   #define dct_rot(out0,out1, x,y,c0,c1) \
+      __m256i c0##xy = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi16((x),(y))), _mm_unpackhi_epi16((x),(y)), 1); \
+      __m256i out0 = _mm256_madd_epi16(c0##xy, c0); \
+      __m256i out1 = _mm256_madd_epi16(c0##xy, c1)
+
+   // out = in << 12  (in 16-bit, out 32-bit)
+   #define dct_widen(out, in) \
+      __m256i out = _mm256_slli_epi32(_mm256_cvtepi16_epi32(in), 12)
+
+   // wide add
+   #define dct_wadd(out, a, b) \
+      __m256i out = _mm256_add_epi32(a, b)
+
+   // wide sub
+   #define dct_wsub(out, a, b) \
+      __m256i out = _mm256_sub_epi32(a, b)
+
+   // butterfly a/b, add bias, then shift by "s" and pack; one pack does both outputs,
+   // leaving qwords sum_l dif_l sum_h dif_h
+   #define dct_bfly32o(out0, out1, a,b,bias,s) \
+      { \
+         __m256i abiased = _mm256_add_epi32(a, bias); \
+         __m256i sum = _mm256_srai_epi32(_mm256_add_epi32(abiased, b), s); \
+         __m256i dif = _mm256_srai_epi32(_mm256_sub_epi32(abiased, b), s); \
+         __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(sum, dif), 0xd8); \
+         out0 = _mm256_castsi256_si128(packed); \
+         out1 = _mm256_extracti128_si256(packed, 1); \
+      }
+
+   // 8-bit interleave step (for transposes)
+   #define dct_interleave8(a, b) \
+      tmp = a; \
+      a = _mm_unpacklo_epi8(a, b); \
+      b = _mm_unpackhi_epi8(tmp, b)
+
+   // 16-bit interleave step (for transposes)
+   #define dct_interleave16(a, b) \
+      tmp = a; \
+      a = _mm_unpacklo_epi16(a, b); \
+      b = _mm_unpackhi_epi16(tmp, b)
+
+   #define dct_pass(bias,shift) \
+      { \
+         /* even part */ \
+         dct_rot(t2e,t3e, row2,row6, rot0_0,rot0_1); \
+         __m128i sum04 = _mm_add_epi16(row0, row4); \
+         __m128i dif04 = _mm_sub_epi16(row0, row4); \
+         dct_widen(t0e, sum04); \
+         dct_widen(t1e, dif04); \
+         dct_wadd(x0, t0e, t3e); \
+         dct_wsub(x3, t0e, t3e); \
+         dct_wadd(x1, t1e, t2e); \
+         dct_wsub(x2, t1e, t2e); \
+         /* odd part */ \
+         dct_rot(y0o,y2o, row7,row3, rot2_0,rot2_1); \
+         dct_rot(y1o,y3o, row5,row1, rot3_0,rot3_1); \
+         __m128i sum17 = _mm_add_epi16(row1, row7); \
+         __m128i sum35 = _mm_add_epi16(row3, row5); \
+         dct_rot(y4o,y5o, sum17,sum35, rot1_0,rot1_1); \
+         dct_wadd(x4, y0o, y4o); \
+         dct_wadd(x5, y1o, y5o); \
+         dct_wadd(x6, y2o, y5o); \
+         dct_wadd(x7, y3o, y4o); \
+         dct_bfly32o(row0,row7, x0,x7,bias,shift); \
+         dct_bfly32o(row1,row6, x1,x6,bias,shift); \
+         dct_bfly32o(row2,row5, x2,x5,bias,shift); \
+         dct_bfly32o(row3,row4, x3,x4,bias,shift); \
+      }
+
+   __m256i rot0_0 = dct_const(stbi__f2f(0.5411961f), stbi__f2f(0.5411961f) + stbi__f2f(-1.847759065f));
+   __m256i rot0_1 = dct_const(stbi__f2f(0.5411961f) + stbi__f2f( 0.765366865f), stbi__f2f(0.5411961f));
+   __m256i rot1_0 = dct_const(stbi__f2f(1.175875602f) + stbi__f2f(-0.899976223f), stbi__f2f(1.175875602f));
+   __m256i rot1_1 = dct_const(stbi__f2f(1.175875602f), stbi__f2f(1.175875602f) + stbi__f2f(-2.562915447f));
+   __m256i rot2_0 = dct_const(stbi__f2f(-1.961570560f) + stbi__f2f( 0.298631336f), stbi__f2f(-1.961570560f));
+   __m256i rot2_1 = dct_const(stbi__f2f(-1.961570560f), stbi__f2f(-1.961570560f) + stbi__f2f( 3.072711026f));
+   __m256i rot3_0 = dct_const(stbi__f2f(-0.390180644f) + stbi__f2f( 2.053119869f), stbi__f2f(-0.390180644f));
+   __m256i rot3_1 = dct_const(stbi__f2f(-0.390180644f), stbi__f2f(-0.390180644f) + stbi__f2f( 1.501321110f));
+
+   // rounding biases in column/row passes, see stbi__idct_block for explanation.
+   __m256i bias_0 = _mm256_set1_epi32(512);
+   __m256i bias_1 = _mm256_set1_epi32(65536 + (128<<17));
+
+   // load
+   row0 = _mm_load_si128((const __m128i *) (data + 0*8));
+   row1 = _mm_load_si128((const __m128i *) (data + 1*8));
+   row2 = _mm_load_si128((const __m128i *) (data + 2*8));
+   row3 = _mm_load_si128((const __m128i *) (data + 3*8));
+   row4 = _mm_load_si128((const __m128i *) (data + 4*8));
+   row5 = _mm_load_si128((const __m128i *) (data + 5*8));
+   row6 = _mm_load_si128((const __m128i *) (data + 6*8));
+   row7 = _mm_load_si128((const __m128i *) (data + 7*8));
+
+   // column pass
+   dct_pass(bias_0, 10);
+
+   {
+      // 16bit 8x8 transpose pass 1
+      dct_interleave16(row0, row4);
+      dct_interleave16(row1, row5);
+      dct_interleave16(row2, row6);
+      dct_interleave16(row3, row7);
+
+      // transpose pass 2
+      dct_interleave16(row0, row2);
+      dct_interleave16(row1, row3);
+      dct_interleave16(row4, row6);
+      dct_interleave16(row5, row7);
+
+      // transpose pass 3
+      dct_interleave16(row0, row1);
+      dct_interleave16(row2, row3);
+      dct_interleave16(row4, row5);
+      dct_interleave16(row6, row7);
+   }
+
+   // row pass
+   dct_pass(bias_1, 17);
+
+   {
+      // pack
+      __m128i p0 = _mm_packus_epi16(row0, row1); // a0a1a2a3...a7b0b1b2b3...b7
+      __m128i p1 = _mm_packus_epi16(row2, row3);
+      __m128i p2 = _mm_packus_epi16(row4, row5);
+      __m128i p3 = _mm_packus_epi16(row6, row7);
+
+      // 8bit 8x8 transpose pass 1
+      dct_interleave8(p0, p2); // a0e0a1e1...
+      dct_interleave8(p1, p3); // c0g0c1g1...
+
+      // transpose pass 2
+      dct_interleave8(p0, p1); // a0c0e0g0...
+      dct_interleave8(p2, p3); // b0d0f0h0...
+
+      // transpose pass 3
+      dct_interleave8(p0, p2); // a0b0c0d0...
+      dct_interleave8(p1, p3); // a4b4c4d4...
+
+      // store
+      _mm_storel_epi64((__m128i *) out, p0); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p0, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p2); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p2, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p1); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p1, 0x4e)); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, p3); out += out_stride;
+      _mm_storel_epi64((__m128i *) out, _mm_shuffle_epi32(p3, 0x4e));
+   }
+
+#undef dct_const
+#undef dct_rot
+#undef dct_widen
+#undef dct_wadd
+#undef dct_wsub
+#undef dct_bfly32o
+#undef dct_interleave8
+#undef dct_interleave16
+#undef dct_pass
+}
+#endif // STBI__SIMD_EXT
+
 #endif // STBI_SSE2
 
 #ifdef STBI_NEON
@@ -3055,6 +3402,65 @@ static stbi_uc *stbi__resample_row_hv_2_simd(stbi_uc *out, stbi_uc *in_near, stb
 }
 #endif
 
+#if defined(STBI_SSE2) && defined(STBI__SIMD_EXT)
+// stbi__resample_row_hv_2_simd 16 pixels at a time. the pixel shifts cross the two 128-bit
+// lanes, so each is an alignr against a lane swap
+static STBI__TARGET("avx2") stbi_uc *stbi__resample_row_hv_2_avx2(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs)
+{
+   int i=0,t0,t1;
+
+   if (w == 1) {
+      out[0] = out[1] = stbi__div4(3*in_near[0] + in_far[0] + 2);
+      return out;
+   }
+
+   t1 = 3*in_near[0] + in_far[0];
+   for (; i < ((w-1) & ~15); i += 16) {
+      // vertical pass, 3*x + y = 4*x + (y - x)
+      __m256i farw  = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (in_far + i)));
+      __m256i nearw = _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (in_near + i)));
+      __m256i curr  = _mm256_add_epi16(_mm256_slli_epi16(nearw, 2), _mm256_sub_epi16(farw, nearw));
+
+      // "prev" is curr shifted right a pixel with t1 in front; "next" is shifted left with
+      // the first pixel of the next block at the end
+      __m256i lo_up = _mm256_permute2x128_si256(curr, curr, 0x08); // 0, curr.lo
+      __m256i hi_dn = _mm256_permute2x128_si256(curr, curr, 0x81); // curr.hi, 0
+      __m256i prev  = _mm256_insert_epi16(_mm256_alignr_epi8(curr, lo_up, 14), t1, 0);
+      __m256i next  = _mm256_insert_epi16(_mm256_alignr_epi8(hi_dn, curr, 2), 3*in_near[i+16] + in_far[i+16], 15);
+
+      // horizontal pass, polyphase as in the SSE2 version
+      __m256i bias = _mm256_set1_epi16(8);
+      __m256i curb = _mm256_add_epi16(_mm256_slli_epi16(curr, 2), bias);
+      __m256i even = _mm256_add_epi16(_mm256_sub_epi16(prev, curr), curb);
+      __m256i odd  = _mm256_add_epi16(_mm256_sub_epi16(next, curr), curb);
+
+      // the in-lane interleave and pack leave the 32 outputs in order
+      __m256i de0  = _mm256_srli_epi16(_mm256_unpacklo_epi16(even, odd), 4);
+      __m256i de1  = _mm256_srli_epi16(_mm256_unpackhi_epi16(even, odd), 4);
+      _mm256_storeu_si256((__m256i *) (out + i*2), _mm256_packus_epi16(de0, de1));
+
+      // "previous" value for next iter
+      t1 = 3*in_near[i+15] + in_far[i+15];
+   }
+
+   t0 = t1;
+   t1 = 3*in_near[i] + in_far[i];
+   out[i*2] = stbi__div16(3*t1 + t0 + 8);
+
+   for (++i; i < w; ++i) {
+      t0 = t1;
+      t1 = 3*in_near[i]+in_far[i];
+      out[i*2-1] = stbi__div16(3*t0 + t1 + 8);
+      out[i*2  ] = stbi__div16(3*t1 + t0 + 8);
+   }
+   out[w*2-1] = stbi__div4(t1+2);
+
+   STBI_NOTUSED(hs);
+
+   return out;
+}
+#endif
+
 static stbi_uc *stbi__resample_row_generic(stbi_uc *out, stbi_uc *in_near, stbi_uc *in_far, int w, int hs)
 {
    // resample with nearest-neighbor
@@ -3259,28 +3665,112 @@ static void stbi__YCbCr_to_RGB_simd(stbi_uc *out, stbi_uc const *y, stbi_uc cons
 }
 #endif
 
-// set up the kernels
-static void stbi__setup_jpeg(stbi__jpeg *j)
+#if defined(STBI_SSE2) && defined(STBI__SIMD_EXT)
+// stbi__YCbCr_to_RGB_simd 16 pixels at a time; the rest goes to the SSE2 version
+static STBI__TARGET("avx2") void stbi__YCbCr_to_RGB_avx2(stbi_uc *out, stbi_uc const *y, stbi_uc const *pcb, stbi_uc const *pcr, int count, int step)
 {
-   j->idct_block_kernel = stbi__idct_block;
-   j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_row;
-   j->resample_row_hv_2_kernel = stbi__resample_row_hv_2;
+   int i = 0;
 
-#ifdef STBI_SSE2
-   if (stbi__sse2_available()) {
-      j->idct_block_kernel = stbi__idct_simd;
-      #ifndef STBI_JPEG_OLD
-      j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
-      #endif
-      j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
+   if (step == 4) {
+      __m256i signflip  = _mm256_set1_epi16(0x80);
+      __m256i cr_const0 = _mm256_set1_epi16(   (short) ( 1.40200f*4096.0f+0.5f));
+      __m256i cr_const1 = _mm256_set1_epi16( - (short) ( 0.71414f*4096.0f+0.5f));
+      __m256i cb_const0 = _mm256_set1_epi16( - (short) ( 0.34414f*4096.0f+0.5f));
+      __m256i cb_const1 = _mm256_set1_epi16(   (short) ( 1.77200f*4096.0f+0.5f));
+      __m256i y_bias = _mm256_set1_epi16(128);
+      __m256i xw = _mm256_set1_epi16(255); // alpha channel
+
+      for (; i+15 < count; i += 16) {
+         // load, widened to one pixel per 16-bit lane in order: y<<8 | 128, (cr-128)<<8, (cb-128)<<8
+         __m256i yw  = _mm256_or_si256(_mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (y+i))), 8), y_bias);
+         __m256i crw = _mm256_slli_epi16(_mm256_xor_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (pcr+i))), signflip), 8);
+         __m256i cbw = _mm256_slli_epi16(_mm256_xor_si256(_mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i *) (pcb+i))), signflip), 8);
+
+         // color transform
+         __m256i yws = _mm256_srli_epi16(yw, 4);
+         __m256i cr0 = _mm256_mulhi_epi16(cr_const0, crw);
+         __m256i cb0 = _mm256_mulhi_epi16(cb_const0, cbw);
+         __m256i cb1 = _mm256_mulhi_epi16(cbw, cb_const1);
+         __m256i cr1 = _mm256_mulhi_epi16(crw, cr_const1);
+         __m256i rws = _mm256_add_epi16(cr0, yws);
+         __m256i gwt = _mm256_add_epi16(cb0, yws);
+         __m256i bws = _mm256_add_epi16(yws, cb1);
+         __m256i gws = _mm256_add_epi16(gwt, cr1);
+
+         // descale
+         __m256i rw = _mm256_srai_epi16(rws, 4);
+         __m256i bw = _mm256_srai_epi16(bws, 4);
+         __m256i gw = _mm256_srai_epi16(gws, 4);
+
+         // back to byte, set up for transpose
+         __m256i brb = _mm256_packus_epi16(rw, bw);
+         __m256i gxb = _mm256_packus_epi16(gw, xw);
+
+         // transpose to interleave channels; each lane ends up with 8 of its pixels
+         __m256i t0 = _mm256_unpacklo_epi8(brb, gxb);
+         __m256i t1 = _mm256_unpackhi_epi8(brb, gxb);
+         __m256i o0 = _mm256_unpacklo_epi16(t0, t1);
+         __m256i o1 = _mm256_unpackhi_epi16(t0, t1);
+
+         // store
+         _mm256_storeu_si256((__m256i *) (out + 0), _mm256_permute2x128_si256(o0, o1, 0x20));
+         _mm256_storeu_si256((__m256i *) (out + 32), _mm256_permute2x128_si256(o0, o1, 0x31));
+         out += 64;
+      }
    }
+
+   stbi__YCbCr_to_RGB_simd(out, y+i, pcb+i, pcr+i, count-i, step);
+}
 #endif
 
-#ifdef STBI_NEON
-   j->idct_block_kernel = stbi__idct_simd;
-   #ifndef STBI_JPEG_OLD
-   j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
-   #endif
+#ifdef STBI_SSE2
+static int stbi__jpeg_simd_limit = STBI_PNG_SIMD_AVX2;
+#endif
+
+STBIDEF void stbi_set_jpeg_simd_limit(int level)
+{
+#ifdef STBI_SSE2
+   stbi__jpeg_simd_limit = level;
+#else
+   STBI_NOTUSED(level);
+#endif
+}
+
+// set up the kernels
+static void stbi__setup_jpeg(stbi__jpeg *j)
+{
+   j->idct_block_kernel = stbi__idct_block;
+   j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_row;
+   j->resample_row_hv_2_kernel = stbi__resample_row_hv_2;
+
+#ifdef STBI_SSE2
+   {
+      int level = stbi__x86_simd_level();
+      if (level > stbi__jpeg_simd_limit) level = stbi__jpeg_simd_limit;
+      if (level >= STBI_PNG_SIMD_SSE2) {
+         j->idct_block_kernel = stbi__idct_simd;
+         #ifndef STBI_JPEG_OLD
+         j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
+         #endif
+         j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
+      }
+#ifdef STBI__SIMD_EXT
+      if (level >= STBI_PNG_SIMD_AVX2) {
+         j->idct_block_kernel = stbi__idct_avx2;
+         #ifndef STBI_JPEG_OLD
+         j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_avx2;
+         #endif
+         j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_avx2;
+      }
+#endif
+   }
+#endif
+
+#ifdef STBI_NEON
+   j->idct_block_kernel = stbi__idct_simd;
+   #ifndef STBI_JPEG_OLD
+   j->YCbCr_to_RGB_kernel = stbi__YCbCr_to_RGB_simd;
+   #endif
    j->resample_row_hv_2_kernel = stbi__resample_row_hv_2_simd;
 #endif
 }
@@ -3475,6 +3965,7 @@ static int stbi__jpeg_info(stbi__context *s, int *x, int *y, int *comp)
 //      - all output is written to a single output buffer (can malloc/realloc)
 //    performance
 //      - fast huffman
+//      - 64-bit bit buffer, two literals per lookup, 8-byte match copies
 
 #ifndef STBI_NO_ZLIB
 
@@ -3482,6 +3973,16 @@ static int stbi__jpeg_info(stbi__context *s, int *x, int *y, int *comp)
 #define STBI__ZFAST_BITS  9 // accelerate all cases in default tables
 #define STBI__ZFAST_MASK  ((1 << STBI__ZFAST_BITS) - 1)
 
+// literal/length table for the fast loop: each entry resolves up to two literals,
+// or one symbol, from STBI__ZLIT_BITS of input
+#define STBI__ZLIT_BITS   11
+#define STBI__ZLIT_MASK   ((1 << STBI__ZLIT_BITS) - 1)
+#define STBI__ZLIT_PAIR   (1 << 17) // bits 9..16 hold a second literal
+// the fast loop runs while it can refill 8 bytes at once and write the longest
+// match (258 bytes) rounded up to whole 8-byte copies
+#define STBI__ZFAST_IN_MARGIN   8
+#define STBI__ZFAST_OUT_MARGIN  (258 + 8)
+
 // zlib-style huffman encoding
 // (jpegs packs from left, zlib from right, so can't share code)
 typedef struct
@@ -3558,6 +4059,51 @@ static int stbi__zbuild_huffman(stbi__zhuffman *z, stbi_uc *sizelist, int num)
    return 1;
 }
 
+// entries are symbol | size << 24, plus STBI__ZLIT_PAIR and the second literal when two
+// literal codes fit; 0 means the code is longer than the table
+static void stbi__zbuild_literal_fast(stbi__uint32 *table, stbi_uc *sizelist, int num)
+{
+   int i, s, code, next_code[16], sizes[16];
+
+   // same canonical codes as stbi__zbuild_huffman, which has already validated sizelist
+   memset(sizes, 0, sizeof(sizes));
+   memset(table, 0, sizeof(*table) << STBI__ZLIT_BITS);
+   for (i=0; i < num; ++i)
+      ++sizes[sizelist[i]];
+   sizes[0] = 0;
+   code = 0;
+   for (i=1; i < 16; ++i) {
+      next_code[i] = code;
+      code = (code + sizes[i]) << 1;
+   }
+   for (i=0; i < num; ++i) {
+      s = sizelist[i];
+      if (s) {
+         if (s <= STBI__ZLIT_BITS) {
+            int j = stbi__bit_reverse(next_code[s],s);
+            while (j < (1 << STBI__ZLIT_BITS)) {
+               table[j] = (stbi__uint32) ((s << 24) | i);
+               j += (1 << s);
+            }
+         }
+         ++next_code[s];
+      }
+   }
+
+   // pair up literals; going downwards, the entry for the remaining bits (i >> s,
+   // always lower) is still a single symbol when it is read
+   for (i=(1 << STBI__ZLIT_BITS)-1; i >= 0; --i) {
+      stbi__uint32 first = table[i];
+      if (first && (first & 511) < 256) {
+         stbi__uint32 second;
+         s = first >> 24;
+         second = table[i >> s];
+         if (second && (second & 511) < 256 && s + (int) (second >> 24) <= STBI__ZLIT_BITS)
+            table[i] = ((s + (second >> 24)) << 24) | STBI__ZLIT_PAIR | ((second & 255) << 9) | (first & 255);
+      }
+   }
+}
+
 // zlib-from-memory implementation for PNG reading
 //    because PNG allows splitting the zlib stream arbitrarily,
 //    and it's annoying structurally to have PNG call ZLIB call PNG,
@@ -3568,14 +4114,20 @@ typedef struct
 {
    stbi_uc *zbuffer, *zbuffer_end;
    int num_bits;
-   stbi__uint32 code_buffer;
+   int num_padding; // zero bytes in code_buffer from reading past zbuffer_end
+   stbi__uint64 code_buffer;
 
    char *zout;
    char *zout_start;
    char *zout_end;
+   char *zout_flush; // if set, decoding pauses once zout reaches it
    int   z_expandable;
 
+   // where stbi__parse_zlib_blocks picks up again after a pause
+   int   z_block, z_final, z_stored_left;
+
    stbi__zhuffman z_length, z_distance;
+   stbi__uint32 z_literal_fast[1 << STBI__ZLIT_BITS];
 } stbi__zbuf;
 
 stbi_inline static stbi_uc stbi__zget8(stbi__zbuf *z)
@@ -3584,20 +4136,36 @@ stbi_inline static stbi_uc stbi__zget8(stbi__zbuf *z)
    return *z->zbuffer++;
 }
 
+stbi_inline static stbi__uint64 stbi__zload64(const stbi_uc *p)
+{
+   // little-endian regardless of the host; compilers turn this into a single load
+   return (stbi__uint64) p[0]       | (stbi__uint64) p[1] <<  8 | (stbi__uint64) p[2] << 16 | (stbi__uint64) p[3] << 24 |
+          (stbi__uint64) p[4] << 32 | (stbi__uint64) p[5] << 40 | (stbi__uint64) p[6] << 48 | (stbi__uint64) p[7] << 56;
+}
+
 static void stbi__fill_bits(stbi__zbuf *z)
 {
+   if (z->zbuffer_end - z->zbuffer >= 8) {
+      // top up with whole bytes from one 8-byte load
+      int n = (63 - z->num_bits) >> 3;
+      z->code_buffer |= (stbi__zload64(z->zbuffer) & ((((stbi__uint64) 1) << (n*8)) - 1)) << z->num_bits;
+      z->zbuffer += n;
+      z->num_bits += n*8;
+      return;
+   }
    do {
-      STBI_ASSERT(z->code_buffer < (1U << z->num_bits));
-      z->code_buffer |= (unsigned int) stbi__zget8(z) << z->num_bits;
+      STBI_ASSERT(z->code_buffer < (((stbi__uint64) 1) << z->num_bits));
+      if (z->zbuffer >= z->zbuffer_end) ++z->num_padding;
+      z->code_buffer |= (stbi__uint64) stbi__zget8(z) << z->num_bits;
       z->num_bits += 8;
-   } while (z->num_bits <= 24);
+   } while (z->num_bits <= 56);
 }
 
 stbi_inline static unsigned int stbi__zreceive(stbi__zbuf *z, int n)
 {
    unsigned int k;
    if (z->num_bits < n) stbi__fill_bits(z);
-   k = z->code_buffer & ((1 << n) - 1);
+   k = (unsigned int) (z->code_buffer & ((1 << n) - 1));
    z->code_buffer >>= n;
    z->num_bits -= n;
    return k;
@@ -3608,7 +4176,7 @@ static int stbi__zhuffman_decode_slowpath(stbi__zbuf *a, stbi__zhuffman *z)
    int b,s,k;
    // not resolved by fast table, so compute it the slow way
    // use jpeg approach, which requires MSbits at top
-   k = stbi__bit_reverse(a->code_buffer, 16);
+   k = stbi__bit_reverse((int) (a->code_buffer & 0xffff), 16);
    for (s=STBI__ZFAST_BITS+1; ; ++s)
       if (k < z->maxcode[s])
          break;
@@ -3635,6 +4203,26 @@ stbi_inline static int stbi__zhuffman_decode(stbi__zbuf *a, stbi__zhuffman *z)
    return stbi__zhuffman_decode_slowpath(a, z);
 }
 
+// decodes from bits already in hand, for the fast loop; returns -1 for an invalid code
+stbi_inline static int stbi__zhuffman_decode_bits(stbi__zhuffman *z, stbi__uint64 bits, int *size)
+{
+   int b,s,k;
+   b = z->fast[bits & STBI__ZFAST_MASK];
+   if (b) {
+      *size = b >> 9;
+      return b & 511;
+   }
+   k = stbi__bit_reverse((int) (bits & 0xffff), 16);
+   for (s=STBI__ZFAST_BITS+1; ; ++s)
+      if (k < z->maxcode[s])
+         break;
+   if (s == 16) return -1;
+   b = (k >> (16-s)) - z->firstcode[s] + z->firstsymbol[s];
+   STBI_ASSERT(z->size[b] == s);
+   *size = s;
+   return z->value[b];
+}
+
 static int stbi__zexpand(stbi__zbuf *z, char *zout, int n)  // need to make room for n bytes
 {
    char *q;
@@ -3668,11 +4256,132 @@ static int stbi__zdist_base[32] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,
 static int stbi__zdist_extra[32] =
 { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
 
+// decodes symbols while there is room to refill and to copy without bounds checks; bits
+// go through locals, since every byte written through zout could alias the stbi__zbuf.
+// returns 1 at the end of the block, 0 on error, and 2 when the margins run out
+static int stbi__parse_huffman_fast(stbi__zbuf *a)
+{
+   stbi_uc *in = a->zbuffer;
+   stbi_uc *in_end = a->zbuffer_end - STBI__ZFAST_IN_MARGIN;
+   char *zout = a->zout;
+   char *zout_end = a->zout_end - STBI__ZFAST_OUT_MARGIN;
+   char *zout_start = a->zout_start;
+   const stbi__uint32 *literal_fast = a->z_literal_fast;
+   stbi__uint64 code_buffer = a->code_buffer;
+   int num_bits = a->num_bits;
+   int result = 2;
+
+   if (a->zout_flush && a->zout_flush - 1 < zout_end) zout_end = a->zout_flush - 1;
+
+   while (in <= in_end && zout <= zout_end) {
+      stbi__uint32 e;
+      int z, s, len, dist;
+      char *p;
+
+      // refill to at least 56 bits, enough for a whole length/distance pair (at most 48);
+      // bits above num_bits may already be set, but only ever to the bytes that go there
+      code_buffer |= stbi__zload64(in) << num_bits;
+      in += (63 - num_bits) >> 3;
+      num_bits |= 56;
+
+      e = literal_fast[code_buffer & STBI__ZLIT_MASK];
+      if (e) {
+         s = e >> 24;
+         z = e & 511;
+         code_buffer >>= s;
+         num_bits -= s;
+         if (e & STBI__ZLIT_PAIR) {
+            zout[0] = (char) z;
+            zout[1] = (char) (e >> 9);
+            zout += 2;
+            continue;
+         }
+      } else {
+         z = stbi__zhuffman_decode_bits(&a->z_length, code_buffer, &s);
+         if (z < 0) { result = stbi__err("bad huffman code","Corrupt PNG"); break; }
+         code_buffer >>= s;
+         num_bits -= s;
+      }
+
+      if (z < 256) {
+         *zout++ = (char) z;
+         continue;
+      }
+      if (z == 256) {
+         result = 1;
+         break;
+      }
+
+      z -= 257;
+      len = stbi__zlength_base[z];
+      if (stbi__zlength_extra[z]) {
+         len += (int) (code_buffer & ((1 << stbi__zlength_extra[z]) - 1));
+         code_buffer >>= stbi__zlength_extra[z];
+         num_bits -= stbi__zlength_extra[z];
+      }
+      z = stbi__zhuffman_decode_bits(&a->z_distance, code_buffer, &s);
+      if (z < 0) { result = stbi__err("bad huffman code","Corrupt PNG"); break; }
+      code_buffer >>= s;
+      num_bits -= s;
+      dist = stbi__zdist_base[z];
+      if (stbi__zdist_extra[z]) {
+         dist += (int) (code_buffer & ((1 << stbi__zdist_extra[z]) - 1));
+         code_buffer >>= stbi__zdist_extra[z];
+         num_bits -= stbi__zdist_extra[z];
+      }
+      if (zout - zout_start < dist) { result = stbi__err("bad dist","Corrupt PNG"); break; }
+
+      // copies may run up to 7 bytes past len, into the margin
+      p = zout - dist;
+      if (dist >= 8) {
+         // each 8 bytes read were written at least one step earlier
+         char *end = zout + len;
+         do {
+            memcpy(zout, p, 8);
+            zout += 8;
+            p += 8;
+         } while (zout < end);
+         zout = end;
+      } else if (dist == 1) { // run of one byte; common in images.
+         char *end = zout + len;
+         stbi__uint64 v = (stbi_uc) *p * (((stbi__uint64) 0x01010101 << 32) | 0x01010101);
+         do {
+            memcpy(zout, &v, 8);
+            zout += 8;
+         } while (zout < end);
+         zout = end;
+      } else {
+         if (len) { do *zout++ = *p++; while (--len); }
+      }
+   }
+
+   // hand back the whole bytes that were read ahead, so the input pointer and
+   // code_buffer look the same as after stbi__fill_bits
+   a->zbuffer = in;
+   a->code_buffer = code_buffer & ((((stbi__uint64) 1) << num_bits) - 1);
+   a->num_bits = num_bits;
+   a->zout = zout;
+   return result;
+}
+
+// returns 1 at the end of the block, 0 on error, 2 when paused at zout_flush
 static int stbi__parse_huffman_block(stbi__zbuf *a)
 {
    char *zout = a->zout;
    for(;;) {
-      int z = stbi__zhuffman_decode(a, &a->z_length);
+      int z;
+      if (a->zbuffer_end - a->zbuffer >= STBI__ZFAST_IN_MARGIN && a->zout_end - zout >= STBI__ZFAST_OUT_MARGIN) {
+         int result;
+         a->zout = zout;
+         result = stbi__parse_huffman_fast(a);
+         if (result != 2) return result;
+         zout = a->zout;
+      }
+      if (a->zout_flush && zout >= a->zout_flush) {
+         a->zout = zout;
+         return 2;
+      }
+      z = stbi__zhuffman_decode(a, &a->z_length);
       if (z < 256) {
          if (z < 0) return stbi__err("bad huffman code","Corrupt PNG"); // error in huffman codes
          if (zout >= a->zout_end) {
@@ -3753,36 +4462,50 @@ static int stbi__compute_huffman_codes(stbi__zbuf *a)
    if (n != hlit+hdist) return stbi__err("bad codelengths","Corrupt PNG");
    if (!stbi__zbuild_huffman(&a->z_length, lencodes, hlit)) return 0;
    if (!stbi__zbuild_huffman(&a->z_distance, lencodes+hlit, hdist)) return 0;
+   stbi__zbuild_literal_fast(a->z_literal_fast, lencodes, hlit);
    return 1;
 }
 
 static int stbi__parse_uncompressed_block(stbi__zbuf *a)
 {
    stbi_uc header[4];
-   int len,nlen,k;
+   int len,nlen,k,buffered;
    if (a->num_bits & 7)
       stbi__zreceive(a, a->num_bits & 7); // discard
-   // drain the bit-packed data into header
+   // code_buffer can hold bytes past the header; put the real ones back in the input,
+   // which is contiguous, and drop the zero padding
+   buffered = a->num_bits >> 3;
+   a->zbuffer -= buffered - (a->num_padding < buffered ? a->num_padding : buffered);
+   a->code_buffer = 0;
+   a->num_bits = 0;
+   a->num_padding = 0;
    k = 0;
-   while (a->num_bits > 0) {
-      header[k++] = (stbi_uc) (a->code_buffer & 255); // suppress MSVC run-time check
-      a->code_buffer >>= 8;
-      a->num_bits -= 8;
-   }
-   STBI_ASSERT(a->num_bits == 0);
    // now fill header the normal way
    while (k < 4)
       header[k++] = stbi__zget8(a);
    len  = header[1] * 256 + header[0];
    nlen = header[3] * 256 + header[2];
    if (nlen != (len ^ 0xffff)) return stbi__err("zlib corrupt","Corrupt PNG");
+   a->z_stored_left = len;
+   return 1;
+}
+
+// copies what is left of a stored block; returns 2 when paused at zout_flush
+static int stbi__copy_uncompressed_block(stbi__zbuf *a)
+{
+   int len = a->z_stored_left;
+   if (a->zout_flush && len > a->zout_flush - a->zout) {
+      len = (int) (a->zout_flush - a->zout);
+      if (len <= 0) return 2;
+   }
    if (a->zbuffer + len > a->zbuffer_end) return stbi__err("read past buffer","Corrupt PNG");
    if (a->zout + len > a->zout_end)
       if (!stbi__zexpand(a, a->zout, len)) return 0;
    memcpy(a->zout, a->zbuffer, len);
    a->zbuffer += len;
    a->zout += len;
-   return 1;
+   a->z_stored_left -= len;
+   return a->z_stored_left ? 2 : 1;
 }
 
 static int stbi__parse_zlib_header(stbi__zbuf *a)
@@ -3811,33 +4534,67 @@ static void stbi__init_zdefaults(void)
    for (i=0; i <=  31; ++i)     stbi__zdefault_distance[i] = 5;
 }
 
-static int stbi__parse_zlib(stbi__zbuf *a, int parse_header)
+enum {
+   STBI__ZBLOCK_none,   // next up is a block header
+   STBI__ZBLOCK_stored,
+   STBI__ZBLOCK_huffman
+};
+
+// the caller sets up zbuffer and zout
+static int stbi__zstart(stbi__zbuf *a, int parse_header)
 {
-   int final, type;
    if (parse_header)
       if (!stbi__parse_zlib_header(a)) return 0;
    a->num_bits = 0;
+   a->num_padding = 0;
    a->code_buffer = 0;
-   do {
-      final = stbi__zreceive(a,1);
-      type = stbi__zreceive(a,2);
-      if (type == 0) {
-         if (!stbi__parse_uncompressed_block(a)) return 0;
-      } else if (type == 3) {
-         return 0;
-      } else {
-         if (type == 1) {
-            // use fixed code lengths
-            if (!stbi__zdefault_distance[31]) stbi__init_zdefaults();
-            if (!stbi__zbuild_huffman(&a->z_length  , stbi__zdefault_length  , 288)) return 0;
-            if (!stbi__zbuild_huffman(&a->z_distance, stbi__zdefault_distance,  32)) return 0;
+   a->z_block = STBI__ZBLOCK_none;
+   a->z_final = 0;
+   return 1;
+}
+
+// decodes until the final block ends (returns 1), or until zout passes zout_flush
+// (returns 2; move the output along and call again to carry on); 0 on error
+static int stbi__parse_zlib_blocks(stbi__zbuf *a)
+{
+   for (;;) {
+      int result;
+      if (a->z_block == STBI__ZBLOCK_none) {
+         int type;
+         if (a->z_final) return 1;
+         a->z_final = stbi__zreceive(a,1);
+         type = stbi__zreceive(a,2);
+         if (type == 0) {
+            if (!stbi__parse_uncompressed_block(a)) return 0;
+            a->z_block = STBI__ZBLOCK_stored;
+         } else if (type == 3) {
+            return 0;
          } else {
-            if (!stbi__compute_huffman_codes(a)) return 0;
+            if (type == 1) {
+               // use fixed code lengths
+               if (!stbi__zdefault_distance[31]) stbi__init_zdefaults();
+               if (!stbi__zbuild_huffman(&a->z_length  , stbi__zdefault_length  , 288)) return 0;
+               if (!stbi__zbuild_huffman(&a->z_distance, stbi__zdefault_distance,  32)) return 0;
+               stbi__zbuild_literal_fast(a->z_literal_fast, stbi__zdefault_length, 288);
+            } else {
+               if (!stbi__compute_huffman_codes(a)) return 0;
+            }
+            a->z_block = STBI__ZBLOCK_huffman;
          }
-         if (!stbi__parse_huffman_block(a)) return 0;
       }
-   } while (!final);
-   return 1;
+      if (a->z_block == STBI__ZBLOCK_stored)
+         result = stbi__copy_uncompressed_block(a);
+      else
+         result = stbi__parse_huffman_block(a);
+      if (result != 1) return result;
+      a->z_block = STBI__ZBLOCK_none;
+   }
+}
+
+static int stbi__parse_zlib(stbi__zbuf *a, int parse_header)
+{
+   if (!stbi__zstart(a, parse_header)) return 0;
+   return stbi__parse_zlib_blocks(a);
 }
 
 static int stbi__do_zlib(stbi__zbuf *a, char *obuf, int olen, int exp, int parse_header)
@@ -3845,6 +4602,7 @@ static int stbi__do_zlib(stbi__zbuf *a, char *obuf, int olen, int exp, int parse
    a->zout_start = obuf;
    a->zout       = obuf;
    a->zout_end   = obuf + olen;
+   a->zout_flush = NULL;
    a->z_expandable = exp;
 
    return stbi__parse_zlib(a, parse_header);
@@ -3933,6 +4691,8 @@ STBIDEF int stbi_zlib_decode_noheader_buffer(char *obuffer, int olen, const char
 //      - allocates lots of intermediate memory
 //        - avoids problem of streaming data between subsystems
 //        - avoids explicit window management
+//        - except for 8-bit non-interlaced images without palette or tRNS,
+//          which inflate through a small window and unfilter as they go
 //    performance
 //      - uses stb_zlib, a PD zlib implementation with fast huffman decoding
 
@@ -4001,7 +4761,367 @@ static int stbi__paeth(int a, int b, int c)
 
 static stbi_uc stbi__depth_scale_table[9] = { 0, 0xff, 0x55, 0, 0x11, 0,0,0, 0x01 };
 
+#ifdef STBI_SSE2
+// SIMD unfiltering for 8-bit RGB and RGBA rows. SSE2 is the baseline on x86; SSSE3 and AVX2
+// kernels are compiled per function (no global -m flags needed) and picked at run time.
+static int stbi__png_simd_limit = STBI_PNG_SIMD_AVX2;
+#endif
+
+STBIDEF void stbi_set_png_simd_limit(int level)
+{
+#ifdef STBI_SSE2
+   stbi__png_simd_limit = level;
+#else
+   STBI_NOTUSED(level);
+#endif
+}
+
+#ifdef STBI_SSE2
+static int stbi__png_simd_level(void)
+{
+   int level = stbi__x86_simd_level();
+   return level < stbi__png_simd_limit ? level : stbi__png_simd_limit;
+}
+
+// one 3- or 4-byte pixel in the low lanes; never touches bytes past the pixel
+static __m128i stbi__png_load_px(const stbi_uc *p, int n)
+{
+   stbi__uint32 v;
+   if (n == 4) memcpy(&v, p, 4);
+   else v = p[0] | (p[1] << 8) | (p[2] << 16);
+   return _mm_cvtsi32_si128((int) v);
+}
+
+static void stbi__png_store_px(stbi_uc *p, __m128i px, int n)
+{
+   stbi__uint32 v = (stbi__uint32) _mm_cvtsi128_si32(px);
+   if (n == 4) { memcpy(p, &v, 4); return; }
+   p[0] = STBI__BYTECAST(v);
+   p[1] = STBI__BYTECAST(v >> 8);
+   p[2] = STBI__BYTECAST(v >> 16);
+}
+
+// the per-pixel kernels below carry the left neighbour in a register and also
+// expand RGB to RGBA when out_n is 4; prior is NULL on the first row (None for Up)
+static __m128i stbi__png_alpha_fill(int img_n, int out_n)
+{
+   return _mm_cvtsi32_si128(img_n != out_n ? (int) 0xff000000 : 0);
+}
+
+static void stbi__png_up_px(stbi_uc *cur, const stbi_uc *prior, const stbi_uc *raw, stbi__uint32 i, stbi__uint32 x, int img_n, int out_n)
+{
+   __m128i alpha = stbi__png_alpha_fill(img_n, out_n);
+   for (; i < x; ++i) {
+      __m128i d = stbi__png_load_px(raw + i*img_n, img_n);
+      if (prior) d = _mm_add_epi8(d, stbi__png_load_px(prior + i*out_n, out_n));
+      stbi__png_store_px(cur + i*out_n, _mm_or_si128(d, alpha), out_n);
+   }
+}
+
+// a holds the already-unfiltered pixel left of i in its low lanes
+static void stbi__png_sub_px(stbi_uc *cur, const stbi_uc *raw, stbi__uint32 i, stbi__uint32 x, int img_n, int out_n, __m128i a)
+{
+   __m128i alpha = stbi__png_alpha_fill(img_n, out_n);
+   for (; i < x; ++i) {
+      a = _mm_or_si128(_mm_add_epi8(stbi__png_load_px(raw + i*img_n, img_n), a), alpha);
+      stbi__png_store_px(cur + i*out_n, a, out_n);
+   }
+}
+
+// Paeth in 16-bit lanes, ties going to a, then b, as in stbi__paeth.
+// ABS is the only difference between the SSE2 and SSSE3 versions.
+#define STBI__PNG_PAETH_PX(ABS)                                                        \
+   __m128i zero  = _mm_setzero_si128();                                                \
+   __m128i alpha = stbi__png_alpha_fill(img_n, out_n);                                 \
+   __m128i a = zero, c = zero;                                                         \
+   stbi__uint32 i;                                                                     \
+   for (i=0; i < x; ++i) {                                                             \
+      __m128i b  = _mm_unpacklo_epi8(stbi__png_load_px(prior + i*out_n, out_n), zero); \
+      __m128i pa = _mm_sub_epi16(b, c);                                                \
+      __m128i pb = _mm_sub_epi16(a, c);                                                \
+      __m128i pc = _mm_add_epi16(pa, pb);                                              \
+      __m128i smallest, use_a, use_b, nearest, d;                                      \
+      pa = ABS(pa);                                                                    \
+      pb = ABS(pb);                                                                    \
+      pc = ABS(pc);                                                                    \
+      smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));                             \
+      use_a    = _mm_cmpeq_epi16(smallest, pa);                                        \
+      use_b    = _mm_andnot_si128(use_a, _mm_cmpeq_epi16(smallest, pb));               \
+      nearest  = _mm_or_si128(_mm_and_si128(use_a, a), _mm_and_si128(use_b, b));       \
+      nearest  = _mm_or_si128(nearest, _mm_andnot_si128(_mm_or_si128(use_a, use_b), c)); \
+      d = _mm_add_epi8(stbi__png_load_px(raw + i*img_n, img_n), _mm_packus_epi16(nearest, zero)); \
+      d = _mm_or_si128(d, alpha);                                                      \
+      stbi__png_store_px(cur + i*out_n, d, out_n);                                     \
+      a = _mm_unpacklo_epi8(d, zero);                                                  \
+      c = b;                                                                           \
+   }
+
+static __m128i stbi__abs_epi16_sse2(__m128i v)
+{
+   return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+static void stbi__png_paeth_px_sse2(stbi_uc *cur, const stbi_uc *prior, const stbi_uc *raw, stbi__uint32 x, int img_n, int out_n)
+{
+   STBI__PNG_PAETH_PX(stbi__abs_epi16_sse2)
+}
+
+// Up with matching channel counts is independent per byte
+static void stbi__png_up_bytes_sse2(stbi_uc *cur, const stbi_uc *prior, const stbi_uc *raw, stbi__uint32 n)
+{
+   stbi__uint32 k = 0;
+   for (; k + 16 <= n; k += 16) {
+      __m128i d = _mm_add_epi8(_mm_loadu_si128((const __m128i *) (raw + k)), _mm_loadu_si128((const __m128i *) (prior + k)));
+      _mm_storeu_si128((__m128i *) (cur + k), d);
+   }
+   for (; k < n; ++k) cur[k] = STBI__BYTECAST(raw[k] + prior[k]);
+}
+
+// Sub on RGBA, four pixels per step: a prefix sum inside the register plus the carry from the left
+static void stbi__png_sub_rgba_sse2(stbi_uc *cur, const stbi_uc *raw, stbi__uint32 x)
+{
+   __m128i a = _mm_setzero_si128();
+   stbi__uint32 i = 0;
+   for (; i + 4 <= x; i += 4) {
+      __m128i d = _mm_loadu_si128((const __m128i *) (raw + i*4));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 4));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 8));
+      d = _mm_add_epi8(d, a);
+      _mm_storeu_si128((__m128i *) (cur + i*4), d);
+      a = _mm_shuffle_epi32(d, _MM_SHUFFLE(3,3,3,3));
+   }
+   stbi__png_sub_px(cur, raw, i, x, 4, 4, a);
+}
+
+#ifdef STBI__SIMD_EXT
+static STBI__TARGET("ssse3") __m128i stbi__abs_epi16_ssse3(__m128i v)
+{
+   return _mm_abs_epi16(v);
+}
+
+static STBI__TARGET("ssse3") void stbi__png_paeth_px_ssse3(stbi_uc *cur, const stbi_uc *prior, const stbi_uc *raw, stbi__uint32 x, int img_n, int out_n)
+{
+   STBI__PNG_PAETH_PX(stbi__abs_epi16_ssse3)
+}
+
+// RGB -> RGBA for None/Up (prior NULL for None) and Sub, four pixels per shuffle.
+// 16-byte loads cover 5 1/3 source pixels, so the loops stop early enough never to read past the row.
+static STBI__TARGET("ssse3") void stbi__png_expand_up_ssse3(stbi_uc *cur, const stbi_uc *prior, const stbi_uc *raw, stbi__uint32 x)
+{
+   __m128i spread = _mm_setr_epi8(0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1);
+   __m128i alpha  = _mm_set1_epi32((int) 0xff000000);
+   stbi__uint32 i = 0;
+   for (; i + 6 <= x; i += 4) {
+      __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (raw + i*3)), spread);
+      if (prior) d = _mm_add_epi8(d, _mm_loadu_si128((const __m128i *) (prior + i*4)));
+      _mm_storeu_si128((__m128i *) (cur + i*4), _mm_or_si128(d, alpha));
+   }
+   stbi__png_up_px(cur, prior, raw, i, x, 3, 4);
+}
+
+static STBI__TARGET("ssse3") void stbi__png_expand_sub_ssse3(stbi_uc *cur, const stbi_uc *raw, stbi__uint32 x)
+{
+   __m128i spread = _mm_setr_epi8(0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1);
+   __m128i alpha  = _mm_set1_epi32((int) 0xff000000);
+   __m128i a = _mm_setzero_si128();
+   stbi__uint32 i = 0;
+   for (; i + 6 <= x; i += 4) {
+      __m128i d = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (raw + i*3)), spread);
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 4));
+      d = _mm_add_epi8(d, _mm_slli_si128(d, 8));
+      d = _mm_or_si128(_mm_add_epi8(d, a), alpha);
+      _mm_storeu_si128((__m128i *) (cur + i*4), d);
+      a = _mm_shuffle_epi32(d, _MM_SHUFFLE(3,3,3,3));
+   }
+   stbi__png_sub_px(cur, raw, i, x, 3, 4, a);
+}
+
+static STBI__TARGET("avx2") void stbi__png_up_bytes_avx2(stbi_uc *cur, const stbi_uc *prior, const stbi_uc *raw, stbi__uint32 n)
+{
+   stbi__uint32 k = 0;
+   for (; k + 32 <= n; k += 32) {
+      __m256i d = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *) (raw + k)), _mm256_loadu_si256((const __m256i *) (prior + k)));
+      _mm256_storeu_si256((__m256i *) (cur + k), d);
+   }
+   for (; k < n; ++k) cur[k] = STBI__BYTECAST(raw[k] + prior[k]);
+}
+#endif // STBI__SIMD_EXT
+
+// unfilters one whole 8-bit row of img_n = 3 or 4 channels into out_n channels;
+// prior is NULL on the first row, where filter has already been through first_row_filter.
+// returns 0 for the cases the C loops do as well or better, which then handle the row:
+// Average (a serial per-byte chain) and RGB -> RGBA None/Up without SSSE3
+static int stbi__png_unfilter_row_simd(int level, int filter, stbi_uc *cur, const stbi_uc *prior, const stbi_uc *raw, stbi__uint32 x, int img_n, int out_n)
+{
+   int same_n = img_n == out_n;
+
+   // with no row above, Paeth always predicts the left pixel
+   if (filter == STBI__F_paeth_first) filter = STBI__F_sub;
+
+   switch (filter) {
+      case STBI__F_none:
+         if (same_n) { memcpy(cur, raw, x*img_n); return 1; }
+#ifdef STBI__SIMD_EXT
+         if (level >= STBI_PNG_SIMD_SSSE3) { stbi__png_expand_up_ssse3(cur, NULL, raw, x); return 1; }
+#endif
+         return 0;
+
+      case STBI__F_up:
+#ifdef STBI__SIMD_EXT
+         if (same_n && level >= STBI_PNG_SIMD_AVX2) { stbi__png_up_bytes_avx2(cur, prior, raw, x*img_n); return 1; }
+         if (!same_n && level >= STBI_PNG_SIMD_SSSE3) { stbi__png_expand_up_ssse3(cur, prior, raw, x); return 1; }
+#endif
+         if (same_n) { stbi__png_up_bytes_sse2(cur, prior, raw, x*img_n); return 1; }
+         return 0;
+
+      case STBI__F_sub:
+         if (img_n == 4) { stbi__png_sub_rgba_sse2(cur, raw, x); return 1; }
+#ifdef STBI__SIMD_EXT
+         if (!same_n && level >= STBI_PNG_SIMD_SSSE3) { stbi__png_expand_sub_ssse3(cur, raw, x); return 1; }
+#endif
+         stbi__png_sub_px(cur, raw, 0, x, img_n, out_n, _mm_setzero_si128());
+         return 1;
+
+      case STBI__F_paeth:
+#ifdef STBI__SIMD_EXT
+         if (level >= STBI_PNG_SIMD_SSSE3) { stbi__png_paeth_px_ssse3(cur, prior, raw, x, img_n, out_n); return 1; }
+#endif
+         stbi__png_paeth_px_sse2(cur, prior, raw, x, img_n, out_n);
+         return 1;
+   }
+   return 0;
+}
+#endif // STBI_SSE2
+
 // create the png data from post-deflated data
+static int stbi__png_row_simd_level(int depth, int img_n)
+{
+#ifdef STBI_SSE2
+   if (depth == 8 && (img_n == 3 || img_n == 4)) return stbi__png_simd_level();
+#else
+   STBI_NOTUSED(depth);
+   STBI_NOTUSED(img_n);
+#endif
+   return STBI_PNG_SIMD_NONE;
+}
+
+// unfilters row j of the x by y image in a->out; raw starts at the row's filter type byte
+static int stbi__create_png_row(stbi__png *a, stbi_uc *raw, int out_n, stbi__uint32 x, stbi__uint32 j, int depth, int simd_level)
+{
+   int bytes = (depth == 16? 2 : 1);
+   int img_n = a->s->img_n; // copy it into a local for later
+   stbi__uint32 i, stride = x*out_n*bytes;
+   stbi__uint32 img_width_bytes = (((img_n * x * depth) + 7) >> 3);
+   int k;
+
+   int output_bytes = out_n*bytes;
+   int filter_bytes = img_n*bytes;
+   int width = x;
+   stbi_uc *cur = a->out + stride*j;
+   stbi_uc *prior = cur - stride;
+   int filter = *raw++;
+
+   if (filter > 4)
+      return stbi__err("invalid filter","Corrupt PNG");
+
+   if (depth < 8) {
+      STBI_ASSERT(img_width_bytes <= x);
+      cur += x*out_n - img_width_bytes; // store output to the rightmost img_len bytes, so we can decode in place
+      filter_bytes = 1;
+      width = img_width_bytes;
+   }
+
+   // if first row, use special filter that doesn't sample previous row
+   if (j == 0) filter = first_row_filter[filter];
+
+#ifdef STBI_SSE2
+   if (simd_level != STBI_PNG_SIMD_NONE && stbi__png_unfilter_row_simd(simd_level, filter, cur, j ? prior : NULL, raw, x, img_n, out_n))
+      return 1;
+#else
+   STBI_NOTUSED(simd_level);
+#endif
+
+   // handle first byte explicitly
+   for (k=0; k < filter_bytes; ++k) {
+      switch (filter) {
+         case STBI__F_none       : cur[k] = raw[k]; break;
+         case STBI__F_sub        : cur[k] = raw[k]; break;
+         case STBI__F_up         : cur[k] = STBI__BYTECAST(raw[k] + prior[k]); break;
+         case STBI__F_avg        : cur[k] = STBI__BYTECAST(raw[k] + (prior[k]>>1)); break;
+         case STBI__F_paeth      : cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(0,prior[k],0)); break;
+         case STBI__F_avg_first  : cur[k] = raw[k]; break;
+         case STBI__F_paeth_first: cur[k] = raw[k]; break;
+      }
+   }
+
+   if (depth == 8) {
+      if (img_n != out_n)
+         cur[img_n] = 255; // first pixel
+      raw += img_n;
+      cur += out_n;
+      prior += out_n;
+   } else if (depth == 16) {
+      if (img_n != out_n) {
+         cur[filter_bytes]   = 255; // first pixel top byte
+         cur[filter_bytes+1] = 255; // first pixel bottom byte
+      }
+      raw += filter_bytes;
+      cur += output_bytes;
+      prior += output_bytes;
+   } else {
+      raw += 1;
+      cur += 1;
+      prior += 1;
+   }
+
+   // this is a little gross, so that we don't switch per-pixel or per-component
+   if (depth < 8 || img_n == out_n) {
+      int nk = (width - 1)*filter_bytes;
+      #define CASE(f) \
+          case f:     \
+             for (k=0; k < nk; ++k)
+      switch (filter) {
+         // "none" filter turns into a memcpy here; make that explicit.
+         case STBI__F_none:         memcpy(cur, raw, nk); break;
+         CASE(STBI__F_sub)          cur[k] = STBI__BYTECAST(raw[k] + cur[k-filter_bytes]); break;
+         CASE(STBI__F_up)           cur[k] = STBI__BYTECAST(raw[k] + prior[k]); break;
+         CASE(STBI__F_avg)          cur[k] = STBI__BYTECAST(raw[k] + ((prior[k] + cur[k-filter_bytes])>>1)); break;
+         CASE(STBI__F_paeth)        cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(cur[k-filter_bytes],prior[k],prior[k-filter_bytes])); break;
+         CASE(STBI__F_avg_first)    cur[k] = STBI__BYTECAST(raw[k] + (cur[k-filter_bytes] >> 1)); break;
+         CASE(STBI__F_paeth_first)  cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(cur[k-filter_bytes],0,0)); break;
+      }
+      #undef CASE
+      raw += nk;
+   } else {
+      STBI_ASSERT(img_n+1 == out_n);
+      #define CASE(f) \
+          case f:     \
+             for (i=x-1; i >= 1; --i, cur[filter_bytes]=255,raw+=filter_bytes,cur+=output_bytes,prior+=output_bytes) \
+                for (k=0; k < filter_bytes; ++k)
+      switch (filter) {
+         CASE(STBI__F_none)         cur[k] = raw[k]; break;
+         CASE(STBI__F_sub)          cur[k] = STBI__BYTECAST(raw[k] + cur[k- output_bytes]); break;
+         CASE(STBI__F_up)           cur[k] = STBI__BYTECAST(raw[k] + prior[k]); break;
+         CASE(STBI__F_avg)          cur[k] = STBI__BYTECAST(raw[k] + ((prior[k] + cur[k- output_bytes])>>1)); break;
+         CASE(STBI__F_paeth)        cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(cur[k- output_bytes],prior[k],prior[k- output_bytes])); break;
+         CASE(STBI__F_avg_first)    cur[k] = STBI__BYTECAST(raw[k] + (cur[k- output_bytes] >> 1)); break;
+         CASE(STBI__F_paeth_first)  cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(cur[k- output_bytes],0,0)); break;
+      }
+      #undef CASE
+
+      // the loop above sets the high byte of the pixels' alpha, but for
+      // 16 bit png files we also need the low byte set. we'll do that here.
+      if (depth == 16) {
+         cur = a->out + stride*j; // start at the beginning of the row again
+         for (i=0; i < x; ++i,cur+=output_bytes) {
+            cur[filter_bytes+1] = 255;
+         }
+      }
+   }
+
+   return 1;
+}
+
 static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 raw_len, int out_n, stbi__uint32 x, stbi__uint32 y, int depth, int color)
 {
    int bytes = (depth == 16? 2 : 1);
@@ -4012,8 +5132,7 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
    int img_n = s->img_n; // copy it into a local for later
 
    int output_bytes = out_n*bytes;
-   int filter_bytes = img_n*bytes;
-   int width = x;
+   int simd_level = stbi__png_row_simd_level(depth, img_n);
 
    STBI_ASSERT(out_n == s->img_n || out_n == s->img_n+1);
    a->out = (stbi_uc *) stbi__malloc(x * y * output_bytes); // extra bytes to write off the end into
@@ -4028,100 +5147,8 @@ static int stbi__create_png_image_raw(stbi__png *a, stbi_uc *raw, stbi__uint32 r
    }
 
    for (j=0; j < y; ++j) {
-      stbi_uc *cur = a->out + stride*j;
-      stbi_uc *prior = cur - stride;
-      int filter = *raw++;
-
-      if (filter > 4)
-         return stbi__err("invalid filter","Corrupt PNG");
-
-      if (depth < 8) {
-         STBI_ASSERT(img_width_bytes <= x);
-         cur += x*out_n - img_width_bytes; // store output to the rightmost img_len bytes, so we can decode in place
-         filter_bytes = 1;
-         width = img_width_bytes;
-      }
-
-      // if first row, use special filter that doesn't sample previous row
-      if (j == 0) filter = first_row_filter[filter];
-
-      // handle first byte explicitly
-      for (k=0; k < filter_bytes; ++k) {
-         switch (filter) {
-            case STBI__F_none       : cur[k] = raw[k]; break;
-            case STBI__F_sub        : cur[k] = raw[k]; break;
-            case STBI__F_up         : cur[k] = STBI__BYTECAST(raw[k] + prior[k]); break;
-            case STBI__F_avg        : cur[k] = STBI__BYTECAST(raw[k] + (prior[k]>>1)); break;
-            case STBI__F_paeth      : cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(0,prior[k],0)); break;
-            case STBI__F_avg_first  : cur[k] = raw[k]; break;
-            case STBI__F_paeth_first: cur[k] = raw[k]; break;
-         }
-      }
-
-      if (depth == 8) {
-         if (img_n != out_n)
-            cur[img_n] = 255; // first pixel
-         raw += img_n;
-         cur += out_n;
-         prior += out_n;
-      } else if (depth == 16) {
-         if (img_n != out_n) {
-            cur[filter_bytes]   = 255; // first pixel top byte
-            cur[filter_bytes+1] = 255; // first pixel bottom byte
-         }
-         raw += filter_bytes;
-         cur += output_bytes;
-         prior += output_bytes;
-      } else {
-         raw += 1;
-         cur += 1;
-         prior += 1;
-      }
-
-      // this is a little gross, so that we don't switch per-pixel or per-component
-      if (depth < 8 || img_n == out_n) {
-         int nk = (width - 1)*filter_bytes;
-         #define CASE(f) \
-             case f:     \
-                for (k=0; k < nk; ++k)
-         switch (filter) {
-            // "none" filter turns into a memcpy here; make that explicit.
-            case STBI__F_none:         memcpy(cur, raw, nk); break;
-            CASE(STBI__F_sub)          cur[k] = STBI__BYTECAST(raw[k] + cur[k-filter_bytes]); break;
-            CASE(STBI__F_up)           cur[k] = STBI__BYTECAST(raw[k] + prior[k]); break;
-            CASE(STBI__F_avg)          cur[k] = STBI__BYTECAST(raw[k] + ((prior[k] + cur[k-filter_bytes])>>1)); break;
-            CASE(STBI__F_paeth)        cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(cur[k-filter_bytes],prior[k],prior[k-filter_bytes])); break;
-            CASE(STBI__F_avg_first)    cur[k] = STBI__BYTECAST(raw[k] + (cur[k-filter_bytes] >> 1)); break;
-            CASE(STBI__F_paeth_first)  cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(cur[k-filter_bytes],0,0)); break;
-         }
-         #undef CASE
-         raw += nk;
-      } else {
-         STBI_ASSERT(img_n+1 == out_n);
-         #define CASE(f) \
-             case f:     \
-                for (i=x-1; i >= 1; --i, cur[filter_bytes]=255,raw+=filter_bytes,cur+=output_bytes,prior+=output_bytes) \
-                   for (k=0; k < filter_bytes; ++k)
-         switch (filter) {
-            CASE(STBI__F_none)         cur[k] = raw[k]; break;
-            CASE(STBI__F_sub)          cur[k] = STBI__BYTECAST(raw[k] + cur[k- output_bytes]); break;
-            CASE(STBI__F_up)           cur[k] = STBI__BYTECAST(raw[k] + prior[k]); break;
-            CASE(STBI__F_avg)          cur[k] = STBI__BYTECAST(raw[k] + ((prior[k] + cur[k- output_bytes])>>1)); break;
-            CASE(STBI__F_paeth)        cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(cur[k- output_bytes],prior[k],prior[k- output_bytes])); break;
-            CASE(STBI__F_avg_first)    cur[k] = STBI__BYTECAST(raw[k] + (cur[k- output_bytes] >> 1)); break;
-            CASE(STBI__F_paeth_first)  cur[k] = STBI__BYTECAST(raw[k] + stbi__paeth(cur[k- output_bytes],0,0)); break;
-         }
-         #undef CASE
-
-         // the loop above sets the high byte of the pixels' alpha, but for
-         // 16 bit png files we also need the low byte set. we'll do that here.
-         if (depth == 16) {
-            cur = a->out + stride*j; // start at the beginning of the row again
-            for (i=0; i < x; ++i,cur+=output_bytes) {
-               cur[filter_bytes+1] = 255;
-            }
-         }
-      }
+      if (!stbi__create_png_row(a, raw, out_n, x, j, depth, simd_level)) return 0;
+      raw += img_width_bytes + 1;
    }
 
    // we make a separate pass to expand bits to pixels; for performance,
@@ -4254,6 +5281,67 @@ static int stbi__create_png_image(stbi__png *a, stbi_uc *image_data, stbi__uint3
    return 1;
 }
 
+// zlib history the streamed decode keeps, and how much it inflates between unfiltering passes
+#define STBI__PNG_STREAM_HISTORY  32768
+#define STBI__PNG_STREAM_CHUNK    65536
+
+// inflates and unfilters in step, through a window of the inflated stream that holds just
+// the zlib history and the rows in flight, instead of inflating the whole image first.
+// only for images that are final once unfiltered: 8-bit, not interlaced, no palette or tRNS.
+// out is the caller's buffer to decode into, or NULL to allocate one
+static int stbi__create_png_image_streamed(stbi__png *a, stbi_uc *idata, stbi__uint32 idata_len, stbi_uc *out, int out_n, int report_rows)
+{
+   stbi__context *s = a->s;
+   stbi__uint32 x = s->img_x, y = s->img_y, j = 0;
+   stbi__uint32 row_len = x * s->img_n + 1; // filter type byte, then the samples
+   stbi__uint32 window_len = STBI__PNG_STREAM_HISTORY + row_len + STBI__PNG_STREAM_CHUNK;
+   int simd_level = stbi__png_row_simd_level(8, s->img_n);
+   int result = 2;
+   stbi_uc *row;
+   stbi__zbuf z;
+
+   a->out = out ? out : (stbi_uc *) stbi__malloc(x * y * out_n);
+   a->expanded = (stbi_uc *) stbi__malloc(window_len + STBI__ZFAST_OUT_MARGIN);
+   if (!a->out || !a->expanded) return stbi__err("outofmem", "Out of memory");
+
+   // decoding pauses at window_len; the margin takes the match that crosses it
+   z.zbuffer = idata;
+   z.zbuffer_end = idata + idata_len;
+   z.zout_start = z.zout = (char *) a->expanded;
+   z.zout_end = z.zout_start + window_len + STBI__ZFAST_OUT_MARGIN;
+   z.zout_flush = z.zout_start + window_len;
+   z.z_expandable = 0;
+   if (!stbi__zstart(&z, 1)) return 0;
+   row = a->expanded;
+
+   while (result == 2) {
+      stbi__uint32 used, keep_from;
+      result = stbi__parse_zlib_blocks(&z);
+      if (!result) return 0;
+
+      // unfilter every row that has arrived, while it is still in cache
+      used = (stbi__uint32) ((stbi_uc *) z.zout - a->expanded);
+      for (; used - (stbi__uint32) (row - a->expanded) >= row_len; row += row_len, ++j) {
+         if (j == y) return stbi__err("not enough pixels","Corrupt PNG"); // too many, in fact
+         if (!stbi__create_png_row(a, row, out_n, x, j, 8, simd_level)) return 0;
+         if (report_rows)
+            s->row_callback(s->row_user_data, stbi__vertically_flip_on_load ? y-1-j : j, a->out + (size_t) j * x * out_n, x, out_n);
+      }
+
+      // keep the history and the partial row, and make room for more
+      keep_from = used > STBI__PNG_STREAM_HISTORY ? used - STBI__PNG_STREAM_HISTORY : 0;
+      if ((stbi__uint32) (row - a->expanded) < keep_from) keep_from = (stbi__uint32) (row - a->expanded);
+      if (result == 2 && keep_from) {
+         memmove(a->expanded, a->expanded + keep_from, used - keep_from);
+         row -= keep_from;
+         z.zout -= keep_from;
+      }
+   }
+
+   if (j != y || row != (stbi_uc *) z.zout) return stbi__err("not enough pixels","Corrupt PNG");
+   return 1;
+}
+
 static int stbi__compute_transparency(stbi__png *z, stbi_uc tc[3], int out_n)
 {
    stbi__context *s = z->s;
@@ -4361,19 +5449,46 @@ static int stbi__reduce_png(stbi__png *p)
    return 1;
 }
 
-static int stbi__unpremultiply_on_load = 0;
-static int stbi__de_iphone_flag = 0;
+static int stbi__unpremultiply_on_load_global = 0;
+static int stbi__de_iphone_flag_global = 0;
 
 STBIDEF void stbi_set_unpremultiply_on_load(int flag_true_if_should_unpremultiply)
 {
-   stbi__unpremultiply_on_load = flag_true_if_should_unpremultiply;
+   stbi__unpremultiply_on_load_global = flag_true_if_should_unpremultiply;
 }
 
 STBIDEF void stbi_convert_iphone_png_to_rgb(int flag_true_if_should_convert)
 {
-   stbi__de_iphone_flag = flag_true_if_should_convert;
+   stbi__de_iphone_flag_global = flag_true_if_should_convert;
 }
 
+#ifndef STBI_THREAD_LOCAL
+#define stbi__unpremultiply_on_load  stbi__unpremultiply_on_load_global
+#define stbi__de_iphone_flag  stbi__de_iphone_flag_global
+#else
+static STBI_THREAD_LOCAL int stbi__unpremultiply_on_load_local, stbi__unpremultiply_on_load_set;
+static STBI_THREAD_LOCAL int stbi__de_iphone_flag_local, stbi__de_iphone_flag_set;
+
+STBIDEF void stbi_set_unpremultiply_on_load_thread(int flag_true_if_should_unpremultiply)
+{
+   stbi__unpremultiply_on_load_local = flag_true_if_should_unpremultiply;
+   stbi__unpremultiply_on_load_set = 1;
+}
+
+STBIDEF void stbi_convert_iphone_png_to_rgb_thread(int flag_true_if_should_convert)
+{
+   stbi__de_iphone_flag_local = flag_true_if_should_convert;
+   stbi__de_iphone_flag_set = 1;
+}
+
+#define stbi__unpremultiply_on_load  (stbi__unpremultiply_on_load_set           \
+                                       ? stbi__unpremultiply_on_load_local      \
+                                       : stbi__unpremultiply_on_load_global)
+#define stbi__de_iphone_flag  (stbi__de_iphone_flag_set                         \
+                                ? stbi__de_iphone_flag_local                    \
+                                : stbi__de_iphone_flag_global)
+#endif // STBI_THREAD_LOCAL
+
 static void stbi__de_iphone(stbi__png *z)
 {
    stbi__context *s = z->s;
@@ -4533,16 +5648,29 @@ static int stbi__parse_png_file(stbi__png *z, int scan, int req_comp)
             if (first) return stbi__err("first not IHDR", "Corrupt PNG");
             if (scan != STBI__SCAN_load) return 1;
             if (z->idata == NULL) return stbi__err("no IDAT","Corrupt PNG");
+            if ((req_comp == s->img_n+1 && req_comp != 3 && !pal_img_n) || has_trans)
+               s->img_out_n = s->img_n+1;
+            else
+               s->img_out_n = s->img_n;
+            if (z->depth == 8 && !interlace && !pal_img_n && !has_trans && !is_iphone) {
+               // rows are done once unfiltered, so there is no need to hold the whole inflated image
+               int final_format = req_comp == 0 || req_comp == s->img_out_n;
+               int report_rows = s->row_callback != NULL && final_format;
+               stbi_uc *out = NULL;
+               if (final_format && s->out_buffer && (size_t) s->img_x * s->img_y * s->img_out_n <= s->out_buffer_size)
+                  out = s->out_buffer;
+               if (!stbi__create_png_image_streamed(z, z->idata, ioff, out, s->img_out_n, report_rows)) return 0;
+               s->rows_delivered = report_rows;
+               STBI_FREE(z->idata); z->idata = NULL;
+               STBI_FREE(z->expanded); z->expanded = NULL;
+               return 1;
+            }
             // initial guess for decoded data size to avoid unnecessary reallocs
             bpl = (s->img_x * z->depth + 7) / 8; // bytes per line, per component
             raw_len = bpl * s->img_y * s->img_n /* pixels */ + s->img_y /* filter mode per row */;
             z->expanded = (stbi_uc *) stbi_zlib_decode_malloc_guesssize_headerflag((char *) z->idata, ioff, raw_len, (int *) &raw_len, !is_iphone);
             if (z->expanded == NULL) return 0; // zlib should set error
             STBI_FREE(z->idata); z->idata = NULL;
-            if ((req_comp == s->img_n+1 && req_comp != 3 && !pal_img_n) || has_trans)
-               s->img_out_n = s->img_n+1;
-            else
-               s->img_out_n = s->img_n;
             if (!stbi__create_png_image(z, z->expanded, raw_len, s->img_out_n, z->depth, color, interlace)) return 0;
             if (has_trans) {
                if (z->depth == 16) {
@@ -4608,7 +5736,8 @@ static unsigned char *stbi__do_png(stbi__png *p, int *x, int *y, int *n, int req
       *y = p->s->img_y;
       if (n) *n = p->s->img_n;
    }
-   STBI_FREE(p->out);      p->out      = NULL;
+   if (p->out != p->s->out_buffer) STBI_FREE(p->out); // the caller's, on failure
+   p->out = NULL;
    STBI_FREE(p->expanded); p->expanded = NULL;
    STBI_FREE(p->idata);    p->idata    = NULL;
 
@@ -0,0 +1,123 @@
+// Cooks sprites into upload-ready textures (format in Project_3/CookedTexture.h), so the
+// game maps them and hands them to glTexImage2D instead of decoding PNGs on every launch.
+//
+//   c++ -std=c++17 -O2 -IProject_3 tools/cook_textures.cpp Project_3/MipChain.cpp -o cook_textures
+//   ./cook_textures Project_3/sprites/*.png
+//
+// Each image.png is written as image.tex beside it. The game loads textures with straight
+// alpha, rows top to bottom, so it only picks up files cooked without --premultiply or --flip.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include "MipChain.h"
+#include "CookedTexture.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static bool read_file(const std::string& path, std::vector<unsigned char>& contents)
+{
+    std::error_code error;
+    if (!fs::is_regular_file(path, error)) return false;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static void premultiply(unsigned char* pixels, size_t pixel_count)
+{
+    for (size_t i = 0; i < pixel_count; i++) {
+        unsigned char* pixel = pixels + i * 4;
+        for (int channel = 0; channel < 3; channel++) pixel[channel] = (unsigned char) ((pixel[channel] * pixel[3] + 127) / 255);
+    }
+}
+
+static void flip_rows(unsigned char* pixels, int width, int height)
+{
+    size_t row_size = (size_t) width * 4;
+    std::vector<unsigned char> row(row_size);
+    for (int y = 0; y < height / 2; y++) {
+        unsigned char* top    = pixels + y * row_size;
+        unsigned char* bottom = pixels + (height - 1 - y) * row_size;
+        memcpy(row.data(), top, row_size);
+        memcpy(top, bottom, row_size);
+        memcpy(bottom, row.data(), row_size);
+    }
+}
+
+static bool cook(const std::string& input, uint32_t flags, bool build_mips)
+{
+    // the encoded bytes are kept to fingerprint the source in the header
+    std::vector<unsigned char> source;
+    if (!read_file(input, source)) {
+        std::cerr << "unable to read " << input << std::endl;
+        return false;
+    }
+
+    int width, height, number_of_components;
+    unsigned char* pixels = stbi_load_from_memory(source.data(), (int) source.size(), &width, &height, &number_of_components, STBI_rgb_alpha);
+    if (pixels == NULL) {
+        std::cerr << input << ": " << stbi_failure_reason() << std::endl;
+        return false;
+    }
+
+    // applied to level 0 first, so every mip is a true downsample of what the game samples
+    if (flags & COOKED_TEXTURE_PREMULTIPLIED) premultiply(pixels, (size_t) width * height);
+    if (flags & COOKED_TEXTURE_FLIPPED) flip_rows(pixels, width, height);
+
+    MipChain mip_chain;
+    if (build_mips) mip_chain.build(pixels, width, height, (flags & COOKED_TEXTURE_PREMULTIPLIED) != 0);
+
+    CookedTextureHeader header = { COOKED_TEXTURE_MAGIC, COOKED_TEXTURE_VERSION, (uint32_t) width, (uint32_t) height,
+                                   (uint32_t) (1 + mip_chain.levels.size()), flags,
+                                   (uint32_t) source.size(), cooked_source_hash(source.data(), source.size()) };
+    unsigned char prefix[COOKED_TEXTURE_DATA_OFFSET] = {};
+    memcpy(prefix, &header, sizeof(header));
+
+    std::string output = input.substr(0, input.rfind('.')) + COOKED_TEXTURE_EXTENSION;
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    file.write((const char*) prefix, sizeof(prefix));
+    file.write((const char*) pixels, (std::streamsize) width * height * 4);
+    file.write((const char*) mip_chain.pixels.data(), (std::streamsize) mip_chain.pixels.size());
+    stbi_image_free(pixels);
+
+    if (!file.good()) {
+        std::cerr << "unable to write " << output << std::endl;
+        return false;
+    }
+    std::cout << output << " (" << width << "x" << height << ", " << header.level_count << " levels)" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t flags = 0;
+    bool build_mips = true;
+    std::vector<std::string> inputs;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--premultiply") flags |= COOKED_TEXTURE_PREMULTIPLIED;
+        else if (argument == "--flip") flags |= COOKED_TEXTURE_FLIPPED;
+        else if (argument == "--no-mips") build_mips = false;
+        else inputs.push_back(argument);
+    }
+
+    if (inputs.empty()) {
+        std::cerr << "usage: " << argv[0] << " [--premultiply] [--flip] [--no-mips] <image>..." << std::endl;
+        return 1;
+    }
+
+    bool succeeded = true;
+    for (size_t i = 0; i < inputs.size(); i++) succeeded = cook(inputs[i], flags, build_mips) && succeeded;
+    return succeeded ? 0 : 1;
+}
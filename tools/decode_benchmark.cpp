@@ -0,0 +1,912 @@
+// Decodes a generated corpus of PNG, JPEG, TGA and GIF files through stb_image and reports, per
+// format, decode speed, heap allocations per image and the most memory one decode held at once.
+//
+//   c++ -std=c++11 -O2 -IProject_3 tools/decode_benchmark.cpp -o decode_benchmark
+//   ./decode_benchmark --save before.txt          # on the old decoder
+//   ./decode_benchmark --baseline before.txt      # on the new one: adds the ratios
+//   ./decode_benchmark Project_3/sprites/*.png    # real files instead, grouped by extension
+//
+// Everything is decoded to RGBA as the game loads it, and MB/s counts those RGBA bytes. The corpus
+// covers small, odd-sized and large images of each color type: PNGs use fixed-Huffman deflate
+// with per-row filters, JPEGs are baseline 4:4:4, 4:2:0 and grey with optimized tables, TGAs raw
+// and RLE, GIFs 256 colours. Lossless files are also checked against the pixels they were
+// written from, so a faster decoder that gets something wrong shows up as a MISMATCH.
+
+#include <cstdlib>
+#include <cstddef>
+
+// ————— ALLOCATION COUNTING ————— //
+// stb_image's allocations carry their size in front, so frees can be counted too
+struct AllocationStats
+{
+    long count     = 0;
+    size_t current = 0;
+    size_t peak    = 0;
+};
+static AllocationStats g_allocations;
+static const size_t ALLOCATION_HEADER = 16;
+
+static void* counted_malloc(size_t size)
+{
+    unsigned char* block = (unsigned char*) malloc(size + ALLOCATION_HEADER);
+    if (block == NULL) return NULL;
+    *(size_t*) block = size;
+    g_allocations.count++;
+    g_allocations.current += size;
+    if (g_allocations.current > g_allocations.peak) g_allocations.peak = g_allocations.current;
+    return block + ALLOCATION_HEADER;
+}
+
+static void counted_free(void* pointer)
+{
+    if (pointer == NULL) return;
+    unsigned char* block = (unsigned char*) pointer - ALLOCATION_HEADER;
+    g_allocations.current -= *(size_t*) block;
+    free(block);
+}
+
+static void* counted_realloc(void* pointer, size_t size)
+{
+    if (pointer == NULL) return counted_malloc(size);
+    unsigned char* block = (unsigned char*) pointer - ALLOCATION_HEADER;
+    size_t old_size = *(size_t*) block;
+
+    block = (unsigned char*) realloc(block, size + ALLOCATION_HEADER);
+    if (block == NULL) return NULL;
+    *(size_t*) block = size;
+    g_allocations.count++;
+    g_allocations.current += size - old_size;
+    if (g_allocations.current > g_allocations.peak) g_allocations.peak = g_allocations.current;
+    return block + ALLOCATION_HEADER;
+}
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC(size) counted_malloc(size)
+#define STBI_REALLOC(pointer, size) counted_realloc(pointer, size)
+#define STBI_FREE(pointer) counted_free(pointer)
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+static const int    MIN_REPEATS      = 5;
+static const double MIN_SAMPLE_MS    = 50.0;
+static const char*  FORMAT_NAMES[]   = { "png", "jpeg", "tga", "gif" };
+static const int    SIZES[][2]       = { { 64, 64 }, { 509, 301 }, { 2048, 2048 } };
+
+typedef std::vector<unsigned char> Bytes;
+
+static void put_u16_le(Bytes& out, unsigned int v) { out.push_back((unsigned char) v); out.push_back((unsigned char) (v >> 8)); }
+static void put_u16_be(Bytes& out, unsigned int v) { out.push_back((unsigned char) (v >> 8)); out.push_back((unsigned char) v); }
+static void put_u32_be(Bytes& out, unsigned int v) { put_u16_be(out, v >> 16); put_u16_be(out, v & 0xffff); }
+
+// ————— TEST IMAGES ————— //
+// flat cells, gradients, a little noise and (with alpha) cut-out edges, roughly like a sprite
+// sheet; smooth gives the gentle gradients of a photographic background instead
+static Bytes make_pixels(int width, int height, int channels, bool smooth, unsigned int seed)
+{
+    Bytes pixels((size_t) width * height * channels);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1664525u + 1013904223u;
+            unsigned char* p = &pixels[((size_t) y * width + x) * channels];
+            int noise = smooth ? (int) (seed >> 29) - 4 : (int) (seed >> 30);
+            bool inside = ((x / 48) + (y / 40)) % 3 != 0;
+
+            int r = smooth ? 128 + (int) (90 * sin(x * 0.011 + y * 0.004)) : (inside ? 40 + (x / 48) * 37 % 200 : x & 0xff);
+            int g = smooth ? 110 + (int) (80 * cos(y * 0.013 - x * 0.002)) : (inside ? 200 - (y / 40) * 23 % 180 : y * 3);
+            int b = smooth ? 100 + (int) (60 * sin((x + y) * 0.007)) : ((x ^ y) >> 2);
+            int value[4] = { r + noise, g + noise, b + noise, inside ? 255 : (int) (seed >> 24 & 0x3f) };
+
+            // grey keeps the detail of the green channel
+            if (channels <= 2) value[0] = value[1];
+            if (channels == 2) value[1] = value[3];
+            for (int c = 0; c < channels; c++) p[c] = (unsigned char) std::max(0, std::min(255, value[c]));
+        }
+    }
+    return pixels;
+}
+
+// 216 colour cube plus 40 greys, as a 256-entry RGB palette
+static Bytes make_palette()
+{
+    Bytes palette;
+    for (int i = 0; i < 216; i++) palette.insert(palette.end(), { (unsigned char) (i / 36 * 51), (unsigned char) (i / 6 % 6 * 51), (unsigned char) (i % 6 * 51) });
+    for (int i = 0; i < 40; i++) palette.insert(palette.end(), 3, (unsigned char) (i * 255 / 39));
+    return palette;
+}
+
+static Bytes make_indices(int width, int height, unsigned int seed)
+{
+    Bytes rgb = make_pixels(width, height, 3, false, seed);
+    Bytes indices((size_t) width * height);
+    for (size_t i = 0; i < indices.size(); i++) {
+        const unsigned char* p = &rgb[i * 3];
+        indices[i] = (unsigned char) ((p[0] + 25) / 51 * 36 + (p[1] + 25) / 51 * 6 + (p[2] + 25) / 51);
+    }
+    return indices;
+}
+
+// what stb_image returns for these pixels when asked for RGBA
+static Bytes expand_to_rgba(const Bytes& pixels, int channels)
+{
+    size_t count = pixels.size() / channels;
+    Bytes rgba(count * 4);
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char* p = &pixels[i * channels];
+        unsigned char* q = &rgba[i * 4];
+        q[0] = p[0];
+        q[1] = channels >= 3 ? p[1] : p[0];
+        q[2] = channels >= 3 ? p[2] : p[0];
+        q[3] = channels == 2 ? p[1] : channels == 4 ? p[3] : 255;
+    }
+    return rgba;
+}
+
+static Bytes lookup_palette(const Bytes& indices, const Bytes& palette, const Bytes& alpha)
+{
+    Bytes rgba(indices.size() * 4);
+    for (size_t i = 0; i < indices.size(); i++) {
+        memcpy(&rgba[i * 4], &palette[indices[i] * 3], 3);
+        rgba[i * 4 + 3] = indices[i] < alpha.size() ? alpha[indices[i]] : 255;
+    }
+    return rgba;
+}
+
+// ————— PNG WRITER ————— //
+static unsigned int crc32_of(const unsigned char* data, size_t size)
+{
+    unsigned int crc = ~0u;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static void put_chunk(Bytes& out, const char* type, const Bytes& data)
+{
+    put_u32_be(out, (unsigned int) data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_u32_be(out, crc32_of(out.data() + start, out.size() - start));
+}
+
+// deflate writes bits from the least significant end
+struct DeflateBits
+{
+    Bytes& out;
+    unsigned int buffer = 0;
+    int count = 0;
+
+    DeflateBits(Bytes& out) : out(out) {}
+    void put(unsigned int bits, int length)
+    {
+        buffer |= bits << count;
+        count  += length;
+        for (; count >= 8; count -= 8, buffer >>= 8) out.push_back((unsigned char) buffer);
+    }
+    // Huffman codes go most significant bit first
+    void put_code(unsigned int code, int length)
+    {
+        unsigned int reversed = 0;
+        for (int i = 0; i < length; i++) reversed |= ((code >> i) & 1) << (length - 1 - i);
+        put(reversed, length);
+    }
+    void flush() { if (count > 0) out.push_back((unsigned char) buffer); buffer = 0; count = 0; }
+};
+
+static const int LENGTH_BASE[]  = { 3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258 };
+static const int LENGTH_EXTRA[] = { 0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0 };
+static const int DIST_BASE[]    = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577 };
+static const int DIST_EXTRA[]   = { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13 };
+
+static void put_fixed_symbol(DeflateBits& bits, int symbol)
+{
+    if (symbol < 144)      bits.put_code(0x30 + symbol, 8);
+    else if (symbol < 256) bits.put_code(0x190 + symbol - 144, 9);
+    else if (symbol < 280) bits.put_code(symbol - 256, 7);
+    else                   bits.put_code(0xc0 + symbol - 280, 8);
+}
+
+// zlib stream of one fixed-Huffman block, greedy LZ77 over a hash chain
+static Bytes deflate_fixed(const Bytes& data)
+{
+    const int WINDOW = 32768, HASH_SIZE = 1 << 15, MAX_CHAIN = 16, MAX_MATCH = 258;
+    Bytes zlib = { 0x78, 0x01 };
+    DeflateBits bits(zlib);
+    bits.put(1, 1); // final block
+    bits.put(1, 2); // fixed Huffman
+
+    std::vector<int> head(HASH_SIZE, -1), previous(WINDOW, -1);
+    size_t size = data.size();
+    auto hash_at = [&](size_t i) { return (int) (((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & (HASH_SIZE - 1)); };
+    auto insert = [&](size_t i) {
+        if (i + 3 > size) return;
+        int hash = hash_at(i);
+        previous[i & (WINDOW - 1)] = head[hash];
+        head[hash] = (int) i;
+    };
+
+    for (size_t i = 0; i < size;) {
+        int best_length = 0, best_distance = 0;
+        if (i + 3 <= size) {
+            int limit = (int) std::min((size_t) MAX_MATCH, size - i);
+            int candidate = head[hash_at(i)];
+            for (int chain = 0; chain < MAX_CHAIN && candidate >= 0 && i - candidate <= (size_t) WINDOW; chain++) {
+                int length = 0;
+                while (length < limit && data[candidate + length] == data[i + length]) length++;
+                if (length > best_length) {
+                    best_length   = length;
+                    best_distance = (int) (i - candidate);
+                    if (length == limit) break;
+                }
+                candidate = previous[candidate & (WINDOW - 1)];
+            }
+        }
+
+        if (best_length < 3) {
+            put_fixed_symbol(bits, data[i]);
+            insert(i++);
+            continue;
+        }
+
+        int code = 0;
+        while (code < 28 && LENGTH_BASE[code + 1] <= best_length) code++;
+        put_fixed_symbol(bits, 257 + code);
+        bits.put(best_length - LENGTH_BASE[code], LENGTH_EXTRA[code]);
+
+        int distance_code = 0;
+        while (distance_code < 29 && DIST_BASE[distance_code + 1] <= best_distance) distance_code++;
+        bits.put_code(distance_code, 5);
+        bits.put(best_distance - DIST_BASE[distance_code], DIST_EXTRA[distance_code]);
+
+        for (int k = 0; k < best_length; k++) insert(i++);
+    }
+    put_fixed_symbol(bits, 256);
+    bits.flush();
+
+    unsigned int s1 = 1, s2 = 0;
+    for (size_t i = 0; i < size; i++) {
+        s1 = (s1 + data[i]) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    put_u32_be(zlib, (s2 << 16) | s1);
+    return zlib;
+}
+
+static int paeth(int a, int b, int c)
+{
+    int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// 8-bit pixels with channels bytes each; color_type 3 takes indices plus palette and tRNS alpha.
+// rows use the filter with the smallest sum of absolute differences, as libpng does
+static Bytes encode_png(const Bytes& pixels, int width, int height, int channels, int color_type,
+                        const Bytes& palette = Bytes(), const Bytes& alpha = Bytes())
+{
+    size_t row_size = (size_t) width * channels;
+    Bytes filtered, candidate(row_size);
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row   = &pixels[y * row_size];
+        const unsigned char* prior = y > 0 ? row - row_size : NULL;
+        int best_filter = 0;
+        long best_cost  = -1;
+        Bytes best_row;
+
+        for (int filter = 0; filter < 5; filter++) {
+            if (color_type == 3 && filter > 0) break;
+            long cost = 0;
+            for (size_t k = 0; k < row_size; k++) {
+                int a = k >= (size_t) channels ? row[k - channels] : 0;
+                int b = prior ? prior[k] : 0;
+                int c = prior && k >= (size_t) channels ? prior[k - channels] : 0;
+                int predicted[5] = { 0, a, b, (a + b) >> 1, paeth(a, b, c) };
+                candidate[k] = (unsigned char) (row[k] - predicted[filter]);
+                cost += abs((signed char) candidate[k]);
+            }
+            if (best_cost < 0 || cost < best_cost) {
+                best_cost   = cost;
+                best_filter = filter;
+                best_row    = candidate;
+            }
+        }
+        filtered.push_back((unsigned char) best_filter);
+        filtered.insert(filtered.end(), best_row.begin(), best_row.end());
+    }
+
+    Bytes png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    Bytes header;
+    put_u32_be(header, width);
+    put_u32_be(header, height);
+    header.insert(header.end(), { 8, (unsigned char) color_type, 0, 0, 0 });
+    put_chunk(png, "IHDR", header);
+    if (!palette.empty()) put_chunk(png, "PLTE", palette);
+    if (!alpha.empty()) put_chunk(png, "tRNS", alpha);
+    put_chunk(png, "IDAT", deflate_fixed(filtered));
+    put_chunk(png, "IEND", Bytes());
+    return png;
+}
+
+// ————— JPEG WRITER ————— //
+// JPEG writes bits from the most significant end and stuffs a zero after every 0xff
+struct JpegBits
+{
+    Bytes& out;
+    unsigned int buffer = 0;
+    int count = 0;
+
+    JpegBits(Bytes& out) : out(out) {}
+    void put(unsigned int bits, int length)
+    {
+        buffer = (buffer << length) | (bits & ((1u << length) - 1));
+        count += length;
+        for (; count >= 8; count -= 8) {
+            unsigned char byte = (unsigned char) (buffer >> (count - 8));
+            out.push_back(byte);
+            if (byte == 0xff) out.push_back(0);
+        }
+    }
+    void flush() { if (count > 0) put((1u << (8 - count)) - 1, 8 - count); }
+};
+
+struct HuffmanTable
+{
+    unsigned char counts[16] = {}; // codes of each length 1..16
+    std::vector<unsigned char> symbols;
+    unsigned int code[256] = {};
+    int length[256]        = {};
+};
+
+// optimal code lengths limited to 16 bits, following the JPEG spec (annex K.2)
+static HuffmanTable build_huffman(const long (&symbol_counts)[256])
+{
+    long frequency[257];
+    int code_size[257], others[257];
+    for (int i = 0; i < 257; i++) {
+        frequency[i] = i < 256 ? symbol_counts[i] : 1; // reserves the all-ones code
+        code_size[i] = 0;
+        others[i]    = -1;
+    }
+
+    for (;;) {
+        int c1 = -1, c2 = -1;
+        for (int i = 0; i < 257; i++) {
+            if (frequency[i] && (c1 < 0 || frequency[i] <= frequency[c1])) c1 = i;
+        }
+        for (int i = 0; i < 257; i++) {
+            if (frequency[i] && i != c1 && (c2 < 0 || frequency[i] <= frequency[c2])) c2 = i;
+        }
+        if (c2 < 0) break;
+
+        frequency[c1] += frequency[c2];
+        frequency[c2] = 0;
+        for (code_size[c1]++; others[c1] >= 0; code_size[c1]++) c1 = others[c1];
+        others[c1] = c2;
+        for (code_size[c2]++; others[c2] >= 0; code_size[c2]++) c2 = others[c2];
+    }
+
+    int bits[33] = {};
+    for (int i = 0; i < 257; i++) if (code_size[i]) bits[code_size[i]]++;
+    for (int i = 32; i > 16; i--) {
+        while (bits[i] > 0) {
+            int j = i - 2;
+            while (bits[j] == 0) j--;
+            bits[i] -= 2;
+            bits[i - 1]++;
+            bits[j + 1] += 2;
+            bits[j]--;
+        }
+    }
+    int longest = 16;
+    while (bits[longest] == 0) longest--;
+    bits[longest]--;
+
+    HuffmanTable table;
+    for (int i = 1; i <= 16; i++) table.counts[i - 1] = (unsigned char) bits[i];
+    for (int size = 1; size <= 32; size++) {
+        for (int symbol = 0; symbol < 256; symbol++) if (code_size[symbol] == size) table.symbols.push_back((unsigned char) symbol);
+    }
+
+    // canonical codes, shortest first
+    unsigned int code = 0;
+    size_t next = 0;
+    for (int size = 1; size <= 16; size++, code <<= 1) {
+        for (int i = 0; i < bits[size]; i++, code++) {
+            table.code[table.symbols[next]]   = code;
+            table.length[table.symbols[next]] = size;
+            next++;
+        }
+    }
+    return table;
+}
+
+static int magnitude_bits(int value)
+{
+    int size = 0;
+    for (value = abs(value); value; value >>= 1) size++;
+    return size;
+}
+
+static void put_marker(Bytes& out, unsigned char marker, const Bytes& payload)
+{
+    out.push_back(0xff);
+    out.push_back(marker);
+    put_u16_be(out, (unsigned int) payload.size() + 2);
+    out.insert(out.end(), payload.begin(), payload.end());
+}
+
+// baseline JPEG of 1 (grey) or 3 channels, 4:2:0 when subsampled, otherwise 4:4:4
+static Bytes encode_jpeg(const Bytes& pixels, int width, int height, int channels, bool subsampled, int quality)
+{
+    static const int LUMA_QUANT[64] = {
+        16, 11, 10, 16, 24, 40, 51, 61,   12, 12, 14, 19, 26, 58, 60, 55,   14, 13, 16, 24, 40, 57, 69, 56,
+        14, 17, 22, 29, 51, 87, 80, 62,   18, 22, 37, 56, 68,109,103, 77,   24, 35, 55, 64, 81,104,113, 92,
+        49, 64, 78, 87,103,121,120,101,   72, 92, 95, 98,112,100,103, 99 };
+    static const int CHROMA_QUANT[8] = { 17, 18, 24, 47, 99, 99, 99, 99 }; // first row/column; 99 elsewhere
+
+    int components = channels == 1 ? 1 : 3;
+    int sampling   = components == 3 && subsampled ? 2 : 1;
+    int mcu_size   = 8 * sampling;
+    int mcus_x = (width + mcu_size - 1) / mcu_size, mcus_y = (height + mcu_size - 1) / mcu_size;
+
+    // zigzag order, and quantizers in natural order scaled as libjpeg does
+    int zigzag[64], quant[2][64];
+    for (int i = 0, x = 0, y = 0; i < 64; i++) {
+        zigzag[i] = y * 8 + x;
+        if ((x + y) % 2 == 0) { if (x == 7) y++; else if (y == 0) x++; else { x++; y--; } }
+        else                  { if (y == 7) x++; else if (x == 0) y++; else { x--; y++; } }
+    }
+    int scale = quality < 50 ? 5000 / quality : 200 - quality * 2;
+    for (int i = 0; i < 64; i++) {
+        int chroma = i / 8 == 0 ? CHROMA_QUANT[i % 8] : i % 8 == 0 ? CHROMA_QUANT[i / 8] : 99;
+        quant[0][i] = std::max(1, std::min(255, (LUMA_QUANT[i] * scale + 50) / 100));
+        quant[1][i] = std::max(1, std::min(255, (chroma * scale + 50) / 100));
+    }
+
+    float basis[8][8];
+    for (int u = 0; u < 8; u++) {
+        for (int x = 0; x < 8; x++) basis[u][x] = (float) ((u == 0 ? sqrt(0.125) : 0.5) * cos((2 * x + 1) * u * 3.14159265358979 / 16));
+    }
+
+    auto sample = [&](int x, int y, int component) {
+        const unsigned char* p = &pixels[((size_t) std::min(y, height - 1) * width + std::min(x, width - 1)) * channels];
+        if (components == 1) return (float) p[0];
+        float r = p[0], g = p[1], b = p[2];
+        if (component == 0) return 0.299f * r + 0.587f * g + 0.114f * b;
+        if (component == 1) return -0.168736f * r - 0.331264f * g + 0.5f * b + 128.0f;
+        return 0.5f * r - 0.418688f * g - 0.081312f * b + 128.0f;
+    };
+
+    // transform and quantize every block in scan order first, so the tables fit the image
+    std::vector<short> blocks;
+    std::vector<int> block_components;
+    for (int my = 0; my < mcus_y; my++) {
+        for (int mx = 0; mx < mcus_x; mx++) {
+            for (int component = 0; component < components; component++) {
+                int per_side = component == 0 ? sampling : 1;
+                int step     = component == 0 ? 1 : sampling;
+                for (int by = 0; by < per_side; by++) {
+                    for (int bx = 0; bx < per_side; bx++) {
+                        float block[64], rows[64];
+                        for (int y = 0; y < 8; y++) {
+                            for (int x = 0; x < 8; x++) {
+                                int px = mx * mcu_size + (bx * 8 + x) * step, py = my * mcu_size + (by * 8 + y) * step;
+                                float sum = 0.0f;
+                                for (int dy = 0; dy < step; dy++) for (int dx = 0; dx < step; dx++) sum += sample(px + dx, py + dy, component);
+                                block[y * 8 + x] = sum / (step * step) - 128.0f;
+                            }
+                        }
+                        for (int y = 0; y < 8; y++) {
+                            for (int u = 0; u < 8; u++) {
+                                float sum = 0.0f;
+                                for (int x = 0; x < 8; x++) sum += block[y * 8 + x] * basis[u][x];
+                                rows[y * 8 + u] = sum;
+                            }
+                        }
+                        const int* q = quant[component == 0 ? 0 : 1];
+                        for (int i = 0; i < 64; i++) {
+                            int u = zigzag[i] % 8, v = zigzag[i] / 8;
+                            float sum = 0.0f;
+                            for (int y = 0; y < 8; y++) sum += rows[y * 8 + u] * basis[v][y];
+                            int value = (int) lround(sum / q[zigzag[i]]);
+                            blocks.push_back((short) std::max(-1023, std::min(1023, value)));
+                        }
+                        block_components.push_back(component);
+                    }
+                }
+            }
+        }
+    }
+
+    // two passes over the coefficients: count the symbols, then write them
+    long dc_counts[2][256] = {}, ac_counts[2][256] = {};
+    HuffmanTable dc_tables[2], ac_tables[2];
+    Bytes scan;
+    JpegBits bits(scan);
+
+    for (int pass = 0; pass < 2; pass++) {
+        int predictor[3] = {};
+        for (size_t n = 0; n < block_components.size(); n++) {
+            const short* block = &blocks[n * 64];
+            int component = block_components[n], table = component == 0 ? 0 : 1;
+
+            int difference = block[0] - predictor[component], size = magnitude_bits(difference);
+            predictor[component] = block[0];
+            if (pass == 0) dc_counts[table][size]++;
+            else {
+                bits.put(dc_tables[table].code[size], dc_tables[table].length[size]);
+                if (size) bits.put(difference < 0 ? difference - 1 : difference, size);
+            }
+
+            int run = 0;
+            for (int i = 1; i < 64; i++) {
+                if (block[i] == 0) {
+                    run++;
+                    continue;
+                }
+                for (; run > 15; run -= 16) {
+                    if (pass == 0) ac_counts[table][0xf0]++;
+                    else bits.put(ac_tables[table].code[0xf0], ac_tables[table].length[0xf0]);
+                }
+                int value = block[i], symbol = (run << 4) | magnitude_bits(value);
+                if (pass == 0) ac_counts[table][symbol]++;
+                else {
+                    bits.put(ac_tables[table].code[symbol], ac_tables[table].length[symbol]);
+                    bits.put(value < 0 ? value - 1 : value, symbol & 15);
+                }
+                run = 0;
+            }
+            if (run > 0) {
+                if (pass == 0) ac_counts[table][0]++;
+                else bits.put(ac_tables[table].code[0], ac_tables[table].length[0]);
+            }
+        }
+
+        if (pass == 0) {
+            for (int table = 0; table < (components == 1 ? 1 : 2); table++) {
+                dc_tables[table] = build_huffman(dc_counts[table]);
+                ac_tables[table] = build_huffman(ac_counts[table]);
+            }
+        }
+    }
+    bits.flush();
+
+    int table_count = components == 1 ? 1 : 2;
+    Bytes jpeg = { 0xff, 0xd8 };
+    Bytes dqt, sof, dht, sos;
+    for (int table = 0; table < table_count; table++) {
+        dqt.push_back((unsigned char) table);
+        for (int i = 0; i < 64; i++) dqt.push_back((unsigned char) quant[table][zigzag[i]]);
+    }
+    sof.push_back(8);
+    put_u16_be(sof, height);
+    put_u16_be(sof, width);
+    sof.push_back((unsigned char) components);
+    for (int component = 0; component < components; component++) {
+        int factor = component == 0 ? sampling : 1;
+        sof.insert(sof.end(), { (unsigned char) (component + 1), (unsigned char) (factor << 4 | factor), (unsigned char) (component == 0 ? 0 : 1) });
+    }
+    for (int table = 0; table < table_count; table++) {
+        const HuffmanTable* pair[2] = { &dc_tables[table], &ac_tables[table] };
+        for (int ac = 0; ac < 2; ac++) {
+            dht.push_back((unsigned char) (ac << 4 | table));
+            dht.insert(dht.end(), pair[ac]->counts, pair[ac]->counts + 16);
+            dht.insert(dht.end(), pair[ac]->symbols.begin(), pair[ac]->symbols.end());
+        }
+    }
+    sos.push_back((unsigned char) components);
+    for (int component = 0; component < components; component++) {
+        int table = component == 0 ? 0 : 1;
+        sos.insert(sos.end(), { (unsigned char) (component + 1), (unsigned char) (table << 4 | table) });
+    }
+    sos.insert(sos.end(), { 0, 63, 0 });
+
+    put_marker(jpeg, 0xdb, dqt);
+    put_marker(jpeg, 0xc0, sof);
+    put_marker(jpeg, 0xc4, dht);
+    put_marker(jpeg, 0xda, sos);
+    jpeg.insert(jpeg.end(), scan.begin(), scan.end());
+    jpeg.insert(jpeg.end(), { 0xff, 0xd9 });
+    return jpeg;
+}
+
+// ————— TGA WRITER ————— //
+// grey (type 3) or BGR(A) truecolor (type 2, or 10 with RLE packets), rows top to bottom
+static Bytes encode_tga(const Bytes& pixels, int width, int height, int channels, bool rle)
+{
+    Bytes tga = { 0, 0, (unsigned char) (channels == 1 ? 3 : rle ? 10 : 2), 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+    put_u16_le(tga, width);
+    put_u16_le(tga, height);
+    tga.push_back((unsigned char) (channels * 8));
+    tga.push_back((unsigned char) (0x20 | (channels == 4 ? 8 : 0)));
+
+    size_t count = (size_t) width * height;
+    auto pixel = [&](size_t i, unsigned char* out) {
+        const unsigned char* p = &pixels[i * channels];
+        if (channels == 1) out[0] = p[0];
+        else {
+            out[0] = p[2]; out[1] = p[1]; out[2] = p[0];
+            if (channels == 4) out[3] = p[3];
+        }
+    };
+
+    unsigned char bgra[4];
+    for (size_t i = 0; i < count;) {
+        if (!rle) {
+            pixel(i++, bgra);
+            tga.insert(tga.end(), bgra, bgra + channels);
+            continue;
+        }
+
+        // runs of two or more repeat; anything else goes out raw, up to 128 pixels a packet
+        size_t run = 1;
+        while (i + run < count && run < 128 && !memcmp(&pixels[(i + run) * channels], &pixels[i * channels], channels)) run++;
+        if (run >= 2) {
+            tga.push_back((unsigned char) (0x80 | (run - 1)));
+            pixel(i, bgra);
+            tga.insert(tga.end(), bgra, bgra + channels);
+            i += run;
+            continue;
+        }
+        size_t raw = 1;
+        while (i + raw < count && raw < 128 &&
+               (i + raw + 1 >= count || memcmp(&pixels[(i + raw) * channels], &pixels[(i + raw + 1) * channels], channels))) raw++;
+        tga.push_back((unsigned char) (raw - 1));
+        for (size_t k = 0; k < raw; k++) {
+            pixel(i + k, bgra);
+            tga.insert(tga.end(), bgra, bgra + channels);
+        }
+        i += raw;
+    }
+    return tga;
+}
+
+// ————— GIF WRITER ————— //
+// one 256-colour frame, LZW with 12-bit codes and a clear code whenever the table fills
+static Bytes encode_gif(const Bytes& indices, int width, int height, const Bytes& palette)
+{
+    Bytes gif = { 'G', 'I', 'F', '8', '9', 'a' };
+    put_u16_le(gif, width);
+    put_u16_le(gif, height);
+    gif.insert(gif.end(), { 0xf7, 0, 0 });
+    gif.insert(gif.end(), palette.begin(), palette.end());
+    gif.push_back(0x2c);
+    put_u16_le(gif, 0);
+    put_u16_le(gif, 0);
+    put_u16_le(gif, width);
+    put_u16_le(gif, height);
+    gif.push_back(0);
+
+    const int MIN_CODE_SIZE = 8, CLEAR = 1 << MIN_CODE_SIZE;
+    Bytes codes;
+    DeflateBits bits(codes); // GIF packs codes least significant bit first too
+    std::vector<unsigned short> next_code(4096 * 256, 0);
+    int code_size = MIN_CODE_SIZE + 1, max_code = CLEAR + 1, current = -1;
+
+    bits.put(CLEAR, code_size);
+    for (size_t i = 0; i < indices.size(); i++) {
+        int value = indices[i];
+        if (current < 0) current = value;
+        else if (next_code[current * 256 + value]) current = next_code[current * 256 + value];
+        else {
+            bits.put(current, code_size);
+            next_code[current * 256 + value] = (unsigned short) ++max_code;
+            if (max_code >= (1 << code_size)) code_size++;
+            if (max_code == 4095) {
+                bits.put(CLEAR, code_size);
+                std::fill(next_code.begin(), next_code.end(), 0);
+                code_size = MIN_CODE_SIZE + 1;
+                max_code  = CLEAR + 1;
+            }
+            current = value;
+        }
+    }
+    bits.put(current, code_size);
+    bits.put(CLEAR, code_size);
+    bits.put(CLEAR + 1, MIN_CODE_SIZE + 1);
+    bits.flush();
+
+    gif.push_back(MIN_CODE_SIZE);
+    for (size_t offset = 0; offset < codes.size(); offset += 255) {
+        size_t length = std::min((size_t) 255, codes.size() - offset);
+        gif.push_back((unsigned char) length);
+        gif.insert(gif.end(), codes.begin() + offset, codes.begin() + offset + length);
+    }
+    gif.push_back(0);
+    gif.push_back(0x3b);
+    return gif;
+}
+
+// ————— CORPUS ————— //
+struct Sample
+{
+    std::string format;
+    std::string name;
+    Bytes file;
+    Bytes expected; // RGBA; empty for lossy files and files from disk
+};
+
+static std::vector<Sample> generate_corpus()
+{
+    std::vector<Sample> samples;
+    Bytes palette = make_palette();
+    Bytes alpha(216, 255);
+    for (int i = 0; i < 216; i += 7) alpha[i] = (unsigned char) (i & 0x7f); // some see-through entries
+
+    for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+        int width = SIZES[s][0], height = SIZES[s][1];
+        std::string size = std::to_string(width) + "x" + std::to_string(height);
+        unsigned int seed = 1000 + s;
+
+        const char* png_names[] = { "", "grey", "grey+alpha", "rgb", "rgba" };
+        const int png_types[]   = { 0, 0, 4, 2, 6 };
+        for (int channels = 1; channels <= 4; channels++) {
+            Bytes pixels = make_pixels(width, height, channels, false, seed);
+            samples.push_back({ "png", size + " " + png_names[channels], encode_png(pixels, width, height, channels, png_types[channels]), expand_to_rgba(pixels, channels) });
+        }
+        Bytes indices = make_indices(width, height, seed);
+        samples.push_back({ "png", size + " palette", encode_png(indices, width, height, 1, 3, palette), lookup_palette(indices, palette, Bytes()) });
+        samples.push_back({ "png", size + " palette+tRNS", encode_png(indices, width, height, 1, 3, palette, alpha), lookup_palette(indices, palette, alpha) });
+
+        Bytes photo = make_pixels(width, height, 3, true, seed), photo_grey = make_pixels(width, height, 1, true, seed);
+        samples.push_back({ "jpeg", size + " 4:2:0", encode_jpeg(photo, width, height, 3, true, 90), Bytes() });
+        samples.push_back({ "jpeg", size + " 4:4:4", encode_jpeg(photo, width, height, 3, false, 90), Bytes() });
+        samples.push_back({ "jpeg", size + " grey", encode_jpeg(photo_grey, width, height, 1, false, 90), Bytes() });
+
+        for (int channels = 1; channels <= 4; channels++) {
+            if (channels == 2) continue;
+            Bytes pixels = make_pixels(width, height, channels, false, seed);
+            samples.push_back({ "tga", size + " " + png_names[channels], encode_tga(pixels, width, height, channels, false), expand_to_rgba(pixels, channels) });
+            if (channels == 4) samples.push_back({ "tga", size + " rgba rle", encode_tga(pixels, width, height, channels, true), expand_to_rgba(pixels, channels) });
+        }
+
+        samples.push_back({ "gif", size + " 256 colours", encode_gif(indices, width, height, palette), lookup_palette(indices, palette, Bytes()) });
+    }
+    return samples;
+}
+
+// ————— BENCHMARK ————— //
+struct FormatResult
+{
+    int files       = 0;
+    double seconds  = 0.0; // sum of each file's median decode
+    double megabytes = 0.0;
+    long allocations = 0;
+    size_t peak      = 0;
+
+    double get_rate() const { return seconds > 0.0 ? megabytes / seconds : 0.0; }
+    double get_allocations_per_decode() const { return files > 0 ? (double) allocations / files : 0.0; }
+};
+
+// false if the file failed to decode or decoded to the wrong pixels
+static bool run(const Sample& sample, FormatResult& result)
+{
+    std::vector<double> times;
+    double elapsed = 0.0;
+    long allocations = 0;
+    size_t peak = 0, size = 0;
+
+    for (int i = 0; i < MIN_REPEATS || elapsed < MIN_SAMPLE_MS; i++) {
+        int width, height, components;
+        size_t before = g_allocations.current;
+        g_allocations.count = 0;
+        g_allocations.peak  = before;
+
+        auto start = std::chrono::steady_clock::now();
+        unsigned char* pixels = stbi_load_from_memory(sample.file.data(), (int) sample.file.size(), &width, &height, &components, STBI_rgb_alpha);
+        times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        elapsed += times.back();
+
+        if (pixels == NULL) {
+            printf("%s %s: %s\n", sample.format.c_str(), sample.name.c_str(), stbi_failure_reason());
+            return false;
+        }
+        size = (size_t) width * height * 4;
+        allocations = g_allocations.count;
+        peak        = g_allocations.peak - before;
+
+        bool matches = sample.expected.empty() || (sample.expected.size() == size && memcmp(sample.expected.data(), pixels, size) == 0);
+        stbi_image_free(pixels);
+        if (!matches) {
+            printf("%s %s: MISMATCH\n", sample.format.c_str(), sample.name.c_str());
+            return false;
+        }
+    }
+
+    std::sort(times.begin(), times.end());
+    result.files++;
+    result.seconds     += times[times.size() / 2] / 1000.0;
+    result.megabytes   += (double) size / (1024.0 * 1024.0);
+    result.allocations += allocations;
+    result.peak         = std::max(result.peak, peak);
+    return true;
+}
+
+// a line of a file written with --save: "format MB/s allocations-per-decode peak-bytes"
+struct BaselineResult
+{
+    double rate;
+    double allocations;
+    double peak;
+};
+
+static std::map<std::string, BaselineResult> load_baseline(const char* filepath)
+{
+    std::map<std::string, BaselineResult> baseline;
+    std::ifstream file(filepath);
+    std::string format;
+    BaselineResult result;
+    while (file >> format >> result.rate >> result.allocations >> result.peak) baseline[format] = result;
+    if (baseline.empty()) printf("no baseline in %s\n", filepath);
+    return baseline;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* save_path     = NULL;
+    const char* baseline_path = NULL;
+    std::vector<Sample> samples;
+
+    for (int i = 1; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--save" && i + 1 < argc) save_path = argv[++i];
+        else if (argument == "--baseline" && i + 1 < argc) baseline_path = argv[++i];
+        else {
+            std::ifstream file(argv[i], std::ios::binary);
+            size_t extension = argument.rfind('.');
+            Sample sample = { extension == std::string::npos ? "other" : argument.substr(extension + 1), argument,
+                              Bytes(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()), Bytes() };
+            samples.push_back(sample);
+        }
+    }
+    if (samples.empty()) samples = generate_corpus();
+
+    // generated formats in a fixed order, then whatever else came from disk
+    std::vector<std::string> formats(FORMAT_NAMES, FORMAT_NAMES + 4);
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (std::find(formats.begin(), formats.end(), samples[i].format) == formats.end()) formats.push_back(samples[i].format);
+    }
+
+    std::map<std::string, FormatResult> results;
+    bool succeeded = true;
+    for (size_t i = 0; i < samples.size(); i++) succeeded = run(samples[i], results[samples[i].format]) && succeeded;
+
+    std::map<std::string, BaselineResult> baseline;
+    if (baseline_path != NULL) baseline = load_baseline(baseline_path);
+
+    printf("%-6s %5s %9s %13s %10s", "format", "files", "MB/s", "allocs/decode", "peak MB");
+    if (!baseline.empty()) printf("   %8s %13s %8s", "speed", "allocs", "peak");
+    printf("\n");
+
+    FILE* save = save_path != NULL ? fopen(save_path, "w") : NULL;
+    if (save_path != NULL && save == NULL) printf("unable to write %s\n", save_path);
+
+    for (size_t i = 0; i < formats.size(); i++) {
+        if (results.count(formats[i]) == 0 || results[formats[i]].files == 0) continue;
+        const FormatResult& result = results[formats[i]];
+        printf("%-6s %5d %9.1f %13.1f %10.2f", formats[i].c_str(), result.files, result.get_rate(),
+               result.get_allocations_per_decode(), result.peak / (1024.0 * 1024.0));
+
+        if (baseline.count(formats[i])) {
+            const BaselineResult& before = baseline[formats[i]];
+            printf("   %7.2fx %+13.1f %7.2fx", result.get_rate() / before.rate,
+                   result.get_allocations_per_decode() - before.allocations, result.peak / before.peak);
+        }
+        printf("\n");
+
+        if (save != NULL) fprintf(save, "%s %.3f %.3f %zu\n", formats[i].c_str(), result.get_rate(), result.get_allocations_per_decode(), result.peak);
+    }
+    if (save != NULL) fclose(save);
+    return succeeded ? 0 : 1;
+}
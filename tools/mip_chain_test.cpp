@@ -0,0 +1,155 @@
+// Checks the mip chain box filter: straight alpha colour must be weighted by alpha, so the RGB
+// of transparent texels never reaches a visible one, and the vector paths must agree with it.
+//
+//   c++ -std=c++11 -O2 -IProject_3 tools/mip_chain_test.cpp Project_3/MipChain.cpp -o mip_chain_test
+//   ./mip_chain_test
+//
+// Exits non-zero on the first failing check.
+
+#include "MipChain.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    printf("%s %s\n", condition ? "ok  " : "FAIL", what);
+    if (!condition) failures++;
+}
+
+static bool pixel_is(const unsigned char* pixel, int red, int green, int blue, int alpha)
+{
+    return pixel[0] == red && pixel[1] == green && pixel[2] == blue && pixel[3] == alpha;
+}
+
+// ————— REFERENCE ————— //
+// the filter written out one pixel at a time
+static void reference_downsample(const std::vector<unsigned char>& source, int width, int height, std::vector<unsigned char>& destination)
+{
+    int half_width  = std::max(1, width / 2);
+    int half_height = std::max(1, height / 2);
+    destination.assign((size_t) half_width * half_height * 4, 0);
+
+    for (int y = 0; y < half_height; y++) {
+        for (int x = 0; x < half_width; x++) {
+            int xs[2] = { 2 * x, std::min(2 * x + 1, width - 1) };
+            int ys[2] = { 2 * y, std::min(2 * y + 1, height - 1) };
+
+            int alpha_sum = 0;
+            for (int j = 0; j < 2; j++) for (int i = 0; i < 2; i++) alpha_sum += source[((size_t) ys[j] * width + xs[i]) * 4 + 3];
+
+            unsigned char* out = &destination[((size_t) y * half_width + x) * 4];
+            out[3] = (unsigned char) ((alpha_sum + 2) / 4);
+            for (int channel = 0; channel < 3; channel++) {
+                int sum = 0, weighted = 0;
+                for (int j = 0; j < 2; j++) {
+                    for (int i = 0; i < 2; i++) {
+                        const unsigned char* texel = &source[((size_t) ys[j] * width + xs[i]) * 4];
+                        sum      += texel[channel];
+                        weighted += texel[channel] * texel[3];
+                    }
+                }
+                out[channel] = (unsigned char) (alpha_sum == 0 ? (sum + 2) / 4 : (weighted + alpha_sum / 2) / alpha_sum);
+            }
+        }
+    }
+}
+
+// ————— CHECKS ————— //
+static void half_transparent_block()
+{
+    // two opaque red texels, two invisible green ones
+    const unsigned char block[16] = { 255, 0, 0, 255,   0, 255, 0, 0,
+                                        0, 255, 0, 0,   255, 0, 0, 255 };
+    unsigned char result[4];
+
+    downsample_box(block, 2, 2, result);
+    check(pixel_is(result, 255, 0, 0, 128), "half-transparent 2x2 block keeps its colour");
+
+    const unsigned char premultiplied[16] = { 255, 0, 0, 255,   0, 0, 0, 0,
+                                                0, 0, 0, 0,     255, 0, 0, 255 };
+    downsample_box(premultiplied, 2, 2, result, true);
+    check(pixel_is(result, 128, 0, 0, 128), "premultiplied 2x2 block is a plain average");
+
+    const unsigned char invisible[16] = { 10, 20, 30, 0,   30, 40, 50, 0,
+                                          50, 60, 70, 0,   70, 80, 90, 0 };
+    downsample_box(invisible, 2, 2, result);
+    check(pixel_is(result, 40, 50, 60, 0), "fully transparent 2x2 block is a plain average");
+}
+
+static void sprite_edges()
+{
+    // an opaque white disc on transparent texels holding pure green, as some exporters leave them
+    const int size = 64;
+    std::vector<unsigned char> image((size_t) size * size * 4);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            unsigned char* pixel = &image[((size_t) y * size + x) * 4];
+            float dx = x - size / 2 + 0.5f, dy = y - size / 2 + 0.5f;
+            bool inside = dx * dx + dy * dy < 24.0f * 24.0f;
+            pixel[0] = inside ? 255 : 0;
+            pixel[1] = 255;
+            pixel[2] = inside ? 255 : 0;
+            pixel[3] = inside ? 255 : 0;
+        }
+    }
+
+    MipChain chain;
+    chain.build(image.data(), size, size);
+
+    bool clean = true;
+    for (int level = 0; level < (int) chain.levels.size(); level++) {
+        const MipLevel& mip = chain.levels[level];
+        const unsigned char* pixels = chain.get_level_pixels(level);
+        for (int i = 0; i < mip.width * mip.height; i++) {
+            const unsigned char* pixel = pixels + i * 4;
+            if (pixel[3] > 0 && !(pixel[0] == 255 && pixel[1] == 255 && pixel[2] == 255)) clean = false;
+        }
+    }
+    check(clean, "no level of a sprite picks up the colour of its transparent texels");
+}
+
+static void matches_reference()
+{
+    // odd sizes and widths that leave a scalar tail; opaque, transparent and partial runs so
+    // every vector step and its fallback are taken
+    const int sizes[][2] = { { 64, 16 }, { 37, 19 }, { 9, 3 }, { 1, 7 }, { 130, 2 } };
+    srand(1);
+
+    bool same = true;
+    for (const auto& size : sizes) {
+        int width = size[0], height = size[1];
+        std::vector<unsigned char> image((size_t) width * height * 4);
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                unsigned char* pixel = &image[((size_t) y * width + x) * 4];
+                for (int channel = 0; channel < 3; channel++) pixel[channel] = (unsigned char) (rand() & 255);
+                int run = (x / 8 + y) % 3;
+                pixel[3] = run == 0 ? 255 : run == 1 ? 0 : (unsigned char) (rand() & 255);
+            }
+        }
+
+        std::vector<unsigned char> expected;
+        reference_downsample(image, width, height, expected);
+        std::vector<unsigned char> actual(expected.size());
+        downsample_box(image.data(), width, height, actual.data());
+        if (actual != expected) {
+            printf("     %dx%d differs from the reference\n", width, height);
+            same = false;
+        }
+    }
+    check(same, "downsample_box matches the per-pixel reference");
+}
+
+int main()
+{
+    half_transparent_block();
+    sprite_edges();
+    matches_reference();
+
+    if (failures > 0) printf("%d check(s) failed\n", failures);
+    return failures > 0 ? 1 : 0;
+}
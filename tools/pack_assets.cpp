@@ -0,0 +1,111 @@
+// Builds the asset pack the game maps at startup (format in Project_3/AssetPack.h).
+//
+//   c++ -std=c++17 -O2 tools/pack_assets.cpp -o pack_assets
+//   ./pack_assets Project_3/assets.pack Project_3 sprites shaders
+//
+// Every regular file under each listed directory is stored under its path relative to
+// the root, e.g. "sprites/tile.png", which is the name the game looks it up by.
+
+#include "../Project_3/AssetPack.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct PackInput
+{
+    std::string name;
+    fs::path    path;
+    std::vector<char> contents;
+};
+
+static bool read_file(const fs::path& path, std::vector<char>& contents)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " <output.pack> <root> <directory>..." << std::endl;
+        return 1;
+    }
+
+    fs::path root = argv[2];
+    std::vector<PackInput> inputs;
+
+    for (int i = 3; i < argc; i++) {
+        fs::path directory = root / argv[i];
+        if (!fs::is_directory(directory)) {
+            std::cerr << "not a directory: " << directory << std::endl;
+            return 1;
+        }
+
+        for (const fs::directory_entry& entry : fs::recursive_directory_iterator(directory)) {
+            if (!entry.is_regular_file()) continue;
+
+            // cached program binaries are driver-specific and never belong in a shipped pack;
+            // hidden files (.DS_Store) are not assets either
+            if (entry.path().extension() == ".bin" || entry.path().filename().string()[0] == '.') continue;
+
+            PackInput input;
+            input.name = fs::relative(entry.path(), root).generic_string();
+            input.path = entry.path();
+            if (input.name.size() >= PACK_NAME_SIZE) {
+                std::cerr << "name too long for the pack index: " << input.name << std::endl;
+                return 1;
+            }
+            if (!read_file(input.path, input.contents)) {
+                std::cerr << "unable to read " << input.path << std::endl;
+                return 1;
+            }
+            inputs.push_back(std::move(input));
+        }
+    }
+
+    // the runtime binary-searches the index
+    std::sort(inputs.begin(), inputs.end(), [](const PackInput& a, const PackInput& b) { return a.name < b.name; });
+
+    PackHeader header = { PACK_MAGIC, PACK_VERSION, (uint32_t) inputs.size(), 0 };
+    std::vector<PackEntry> entries(inputs.size());
+
+    uint64_t offset = sizeof(PackHeader) + entries.size() * sizeof(PackEntry);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        offset = (offset + PACK_ALIGNMENT - 1) / PACK_ALIGNMENT * PACK_ALIGNMENT;
+
+        memset(&entries[i], 0, sizeof(PackEntry));
+        memcpy(entries[i].name, inputs[i].name.c_str(), inputs[i].name.size());
+        entries[i].offset = offset;
+        entries[i].size   = inputs[i].contents.size();
+        offset += entries[i].size;
+    }
+
+    std::ofstream output(argv[1], std::ios::binary | std::ios::trunc);
+    if (!output) {
+        std::cerr << "unable to write " << argv[1] << std::endl;
+        return 1;
+    }
+
+    output.write((const char*) &header, sizeof(header));
+    output.write((const char*) entries.data(), entries.size() * sizeof(PackEntry));
+
+    static const char padding[PACK_ALIGNMENT] = {};
+    for (size_t i = 0; i < inputs.size(); i++) {
+        output.write(padding, (std::streamsize) (entries[i].offset - (uint64_t) output.tellp()));
+        output.write(inputs[i].contents.data(), (std::streamsize) inputs[i].contents.size());
+        std::cout << entries[i].name << " (" << entries[i].size << " bytes)" << std::endl;
+    }
+
+    std::cout << "wrote " << inputs.size() << " assets, " << offset << " bytes, to " << argv[1] << std::endl;
+    return output.good() ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+// Times stb_image PNG decoding at each SIMD unfilter level and checks they all agree.
+//
+//   c++ -std=c++11 -O2 -IProject_3 tools/png_benchmark.cpp -o png_benchmark
+//   ./png_benchmark                        # generated 2048x2048 sprite sheets, one per filter
+//   ./png_benchmark Project_3/sprites/*.png
+//
+// Generated sheets are written with stored (uncompressed) deflate blocks, so inflate is a
+// memcpy and the numbers isolate unfiltering; real files show the end-to-end gain.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+static const int   DECODE_REPEATS = 15;
+static const char* LEVEL_NAMES[]  = { "scalar", "SSE2", "SSSE3", "AVX2" };
+
+// ————— PNG WRITER ————— //
+static unsigned int crc32_of(const unsigned char* data, size_t size, unsigned int crc = 0)
+{
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static void put_u32(std::vector<unsigned char>& out, unsigned int v)
+{
+    unsigned char bytes[4] = { (unsigned char) (v >> 24), (unsigned char) (v >> 16), (unsigned char) (v >> 8), (unsigned char) v };
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+static void put_chunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data)
+{
+    put_u32(out, (unsigned int) data.size());
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    put_u32(out, crc32_of(out.data() + start, out.size() - start));
+}
+
+static int paeth(int a, int b, int c)
+{
+    int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+// filter < 0 cycles through all five filters row by row
+static std::vector<unsigned char> encode_png(const std::vector<unsigned char>& pixels, int width, int height, int channels, int filter)
+{
+    size_t row_size   = (size_t) width * channels;
+    size_t pixel_size = (size_t) channels;
+    std::vector<unsigned char> filtered;
+    for (int y = 0; y < height; y++) {
+        int row_filter = filter < 0 ? y % 5 : filter;
+        const unsigned char* row   = &pixels[y * row_size];
+        const unsigned char* prior = y > 0 ? row - row_size : NULL;
+        filtered.push_back((unsigned char) row_filter);
+
+        for (size_t k = 0; k < row_size; k++) {
+            int a = k >= pixel_size ? row[k - pixel_size] : 0;
+            int b = prior ? prior[k] : 0;
+            int c = prior && k >= pixel_size ? prior[k - pixel_size] : 0;
+            int predicted[5] = { 0, a, b, (a + b) >> 1, paeth(a, b, c) };
+            filtered.push_back((unsigned char) (row[k] - predicted[row_filter]));
+        }
+    }
+
+    // zlib stream of stored blocks
+    std::vector<unsigned char> zlib = { 0x78, 0x01 };
+    for (size_t offset = 0; offset < filtered.size(); offset += 65535) {
+        size_t length = std::min((size_t) 65535, filtered.size() - offset);
+        zlib.push_back(offset + length == filtered.size() ? 1 : 0);
+        zlib.push_back((unsigned char) length);
+        zlib.push_back((unsigned char) (length >> 8));
+        zlib.push_back((unsigned char) ~length);
+        zlib.push_back((unsigned char) (~length >> 8));
+        zlib.insert(zlib.end(), filtered.begin() + offset, filtered.begin() + offset + length);
+    }
+    unsigned int s1 = 1, s2 = 0;
+    for (size_t i = 0; i < filtered.size(); i++) {
+        s1 = (s1 + filtered[i]) % 65521;
+        s2 = (s2 + s1) % 65521;
+    }
+    put_u32(zlib, (s2 << 16) | s1);
+
+    std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    std::vector<unsigned char> header;
+    put_u32(header, width);
+    put_u32(header, height);
+    header.insert(header.end(), { 8, (unsigned char) (channels == 4 ? 6 : 2), 0, 0, 0 });
+    put_chunk(png, "IHDR", header);
+    put_chunk(png, "IDAT", zlib);
+    put_chunk(png, "IEND", std::vector<unsigned char>());
+    return png;
+}
+
+// smooth gradients, hard-edged cells and a little noise, roughly like a sheet of sprites
+static std::vector<unsigned char> make_sheet(int width, int height, int channels)
+{
+    std::vector<unsigned char> pixels((size_t) width * height * channels);
+    unsigned int seed = 12345;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1664525u + 1013904223u;
+            unsigned char* p = &pixels[((size_t) y * width + x) * channels];
+            bool inside = ((x / 64) + (y / 64)) % 3 != 0;
+            p[0] = (unsigned char) (x + (seed >> 29));
+            p[1] = (unsigned char) (y * 3);
+            p[2] = (unsigned char) ((x ^ y) >> 2);
+            if (channels == 4) p[3] = inside ? 255 : (unsigned char) (seed >> 24 & 0x1f);
+        }
+    }
+    return pixels;
+}
+
+// ————— BENCHMARK ————— //
+struct Sample
+{
+    std::string name;
+    std::vector<unsigned char> file;
+};
+
+// stb_image never goes above what the CPU supports, so this only trims levels that would repeat
+static int supported_level()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (__builtin_cpu_supports("avx2"))  return STBI_PNG_SIMD_AVX2;
+    if (__builtin_cpu_supports("ssse3")) return STBI_PNG_SIMD_SSSE3;
+    return STBI_PNG_SIMD_SSE2;
+#elif defined(_M_X64) || defined(_M_IX86)
+    return STBI_PNG_SIMD_AVX2;
+#else
+    return STBI_PNG_SIMD_NONE;
+#endif
+}
+
+static void run(const Sample& sample, int req_comp, int max_level)
+{
+    std::vector<unsigned char> reference;
+    double scalar_ms = 0.0;
+
+    for (int level = STBI_PNG_SIMD_NONE; level <= max_level; level++) {
+        stbi_set_png_simd_limit(level);
+
+        std::vector<double> times;
+        int width = 0, height = 0, components = 0;
+        for (int i = 0; i < DECODE_REPEATS; i++) {
+            auto start = std::chrono::steady_clock::now();
+            unsigned char* pixels = stbi_load_from_memory(sample.file.data(), (int) sample.file.size(), &width, &height, &components, req_comp);
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+            if (pixels == NULL) {
+                printf("%s: %s\n", sample.name.c_str(), stbi_failure_reason());
+                return;
+            }
+
+            size_t size = (size_t) width * height * (req_comp ? req_comp : components);
+            if (i == 0 && level == STBI_PNG_SIMD_NONE) reference.assign(pixels, pixels + size);
+            else if (i == 0 && memcmp(reference.data(), pixels, size) != 0) printf("  MISMATCH at %s\n", LEVEL_NAMES[level]);
+            stbi_image_free(pixels);
+        }
+
+        std::sort(times.begin(), times.end());
+        double median = times[times.size() / 2];
+        if (level == STBI_PNG_SIMD_NONE) scalar_ms = median;
+
+        double megabytes = (double) reference.size() / (1024.0 * 1024.0);
+        printf("  %-6s %8.2f ms %8.1f MB/s  x%.2f\n", LEVEL_NAMES[level], median, megabytes / (median / 1000.0), scalar_ms / median);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<Sample> samples;
+    const char* filter_names[] = { "none", "sub", "up", "average", "paeth" };
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            std::ifstream file(argv[i], std::ios::binary);
+            Sample sample = { argv[i], std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()) };
+            samples.push_back(sample);
+        }
+    }
+    else {
+        const int size = 2048;
+        for (int channels = 3; channels <= 4; channels++) {
+            std::vector<unsigned char> pixels = make_sheet(size, size, channels);
+            for (int filter = -1; filter < 5; filter++) {
+                Sample sample;
+                sample.name = std::string(channels == 4 ? "RGBA " : "RGB ") + (filter < 0 ? "mixed" : filter_names[filter]);
+                sample.file = encode_png(pixels, size, size, channels, filter);
+                samples.push_back(sample);
+            }
+        }
+    }
+
+    int max_level = supported_level();
+    for (size_t i = 0; i < samples.size(); i++) {
+        printf("%s\n", samples[i].name.c_str());
+        run(samples[i], 0, max_level);
+
+        // RGB files loaded as RGBA, as the game does, go through the expanding kernels
+        int width, height, components;
+        if (stbi_info_from_memory(samples[i].file.data(), (int) samples[i].file.size(), &width, &height, &components) && components == 3) {
+            printf(" as RGBA\n");
+            run(samples[i], STBI_rgb_alpha, max_level);
+        }
+    }
+    return 0;
+}